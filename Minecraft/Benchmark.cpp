@@ -0,0 +1,414 @@
+#include <AABBBatch.h>
+#include <AllocationStats.h>
+#include <Chunk.h>
+#include <ChunkManager.h>
+#include <Frustum.h>
+#include <JobQueue.h>
+#include <PerlinNoise.h>
+#include <SplitMix64.h>
+#include <TerrainGenerator.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Benchmark bez okna i kontekstu OpenGL - mierzy tylko prace CPU: generowanie, widocznosc,
+// siatki i promienie. Swiaty sa generowane ze stalego ziarna, wiec wyniki mozna porownywac miedzy przebiegami.
+// Przed pomiarami sprawdza zgodnosc sciezek SIMD z ich skalarnymi odpowiednikami; niezgodnosc konczy program kodem 1.
+
+
+/** Command line: [--seed number] [--min-time milliseconds] [--filter text] [--format table|csv|json]. */
+struct Options {
+    uint64_t m_seed{ 12345 };
+    std::chrono::milliseconds m_minTime{ 500 };
+    std::string m_filter;
+    std::string m_format{ "table" };
+};
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.m_seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.m_minTime = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.m_filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            options.m_format = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+        }
+    }
+    return options;
+}
+
+/** Result of one benchmark. An operation is the unit given by the benchmark (a noise sample,
+ * a chunk, a ray), blocks are the chunk blocks processed by all operations.
+ */
+struct Result {
+    std::string m_name;
+    std::string m_config;
+    uint64_t m_operations{ 0 };
+    uint64_t m_blocks{ 0 };
+    double m_seconds{ 0 };
+    AllocationStats m_allocations;
+
+    double NanosecondsPerOperation() const { return m_seconds * 1e9 / std::max<uint64_t>(m_operations, 1); }
+    double BlocksPerSecond() const { return m_seconds > 0 ? m_blocks / m_seconds : 0; }
+    double AllocationsPerOperation() const {
+        return static_cast<double>(m_allocations.m_allocations) / std::max<uint64_t>(m_operations, 1);
+    }
+};
+
+/** Runs benchmarks and collects their results. */
+class Runner {
+public:
+    explicit Runner(const Options& options) : m_options(options) {}
+
+    bool IsEnabled(const std::string& name) const {
+        return m_options.m_filter.empty() || name.find(m_options.m_filter) != std::string::npos;
+    }
+
+    /** Calls run(iteration) until at least the minimum time passes; every call performs
+     * operationsPerCall operations, processing blocksPerCall blocks. The first call is a warm up
+     * and is not measured, so lazily allocated buffers do not count as allocations.
+     */
+    template <typename Func>
+    void Measure(const std::string& name, const std::string& config, uint64_t operationsPerCall,
+        uint64_t blocksPerCall, Func&& run) {
+        if (!IsEnabled(name)) {
+            return;
+        }
+        run(size_t{ 0 });
+
+        Result result;
+        result.m_name = name;
+        result.m_config = config;
+        const AllocationStats allocationsBefore = AllocationStats::Current();
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration elapsed{ 0 };
+        size_t calls = 0;
+        do {
+            run(++calls);
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < m_options.m_minTime);
+
+        result.m_seconds = std::chrono::duration<double>(elapsed).count();
+        result.m_allocations = AllocationStats::Current() - allocationsBefore;
+        result.m_operations = calls * operationsPerCall;
+        result.m_blocks = calls * blocksPerCall;
+        m_results.push_back(result);
+        // Postep na stderr, zeby nie mieszal sie z wynikami
+        std::cerr << name << " " << config << ": " << result.NanosecondsPerOperation() << " ns/op" << std::endl;
+    }
+
+    void Print(std::ostream& out) const {
+        if (m_options.m_format == "json") {
+            // Jeden obiekt JSON na wiersz
+            for (const Result& result : m_results) {
+                out << "{\"name\":\"" << result.m_name << "\",\"config\":\"" << result.m_config
+                    << "\",\"seed\":" << m_options.m_seed
+                    << ",\"operations\":" << result.m_operations
+                    << ",\"seconds\":" << result.m_seconds
+                    << ",\"ns_per_op\":" << result.NanosecondsPerOperation()
+                    << ",\"blocks_per_s\":" << result.BlocksPerSecond()
+                    << ",\"allocations\":" << result.m_allocations.m_allocations
+                    << ",\"allocated_bytes\":" << result.m_allocations.m_allocatedBytes
+                    << ",\"allocations_per_op\":" << result.AllocationsPerOperation() << "}\n";
+            }
+        }
+        else if (m_options.m_format == "csv") {
+            out << "name,config,seed,operations,seconds,ns_per_op,blocks_per_s,allocations,allocated_bytes,allocations_per_op\n";
+            for (const Result& result : m_results) {
+                out << result.m_name << "," << result.m_config << "," << m_options.m_seed << ","
+                    << result.m_operations << "," << result.m_seconds << ","
+                    << result.NanosecondsPerOperation() << "," << result.BlocksPerSecond() << ","
+                    << result.m_allocations.m_allocations << "," << result.m_allocations.m_allocatedBytes << ","
+                    << result.AllocationsPerOperation() << "\n";
+            }
+        }
+        else {
+            out << "Seed: " << m_options.m_seed << "\n";
+            out << std::left << std::setw(28) << "benchmark" << std::setw(14) << "config"
+                << std::right << std::setw(14) << "ns/op" << std::setw(16) << "blocks/s"
+                << std::setw(14) << "allocs/op" << "\n";
+            for (const Result& result : m_results) {
+                out << std::left << std::setw(28) << result.m_name << std::setw(14) << result.m_config
+                    << std::right << std::fixed << std::setprecision(1)
+                    << std::setw(14) << result.NanosecondsPerOperation()
+                    << std::setw(16) << std::setprecision(0) << result.BlocksPerSecond()
+                    << std::setw(14) << std::setprecision(3) << result.AllocationsPerOperation() << "\n";
+                out.unsetf(std::ios::fixed);
+                out << std::setprecision(6);
+            }
+        }
+        out << std::flush;
+    }
+
+private:
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+/** Random unit-ish direction pointing down, rays from above the terrain hit it at a varying angle. */
+glm::vec3 DownwardDirection(SplitMix64& random) {
+    const float x = static_cast<float>(random.NextBelow(1001)) / 1000.0f - 0.5f;
+    const float z = static_cast<float>(random.NextBelow(1001)) / 1000.0f - 0.5f;
+    return glm::normalize(glm::vec3(x, -1.0f, z));
+}
+
+/** Uniform number in [min, max], in 1/1000 steps of the range. */
+float RandomIn(SplitMix64& random, float min, float max) {
+    return min + (max - min) * static_cast<float>(random.NextBelow(1001)) / 1000.0f;
+}
+
+/** Compares AABBBatch::Hit with HitScalar (bit for bit) and AABBBatch::Cull with
+ * Frustum::Intersects on random boxes, rays and frusta. Batch sizes vary, so the scalar tails
+ * of the SIMD loops are covered too. Prints every mismatch, returns their number.
+ */
+size_t RunBatchChecks(uint64_t seed) {
+    constexpr size_t s_caseCount = 20000;
+    constexpr uint32_t s_maxBoxes = 37;
+
+    SplitMix64 random(seed);
+    AABBBatch batch;
+    std::vector<glm::vec3> mins;
+    std::vector<glm::vec3> maxs;
+    std::vector<uint8_t> visible;
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < s_caseCount; ++i) {
+        batch.Clear();
+        mins.clear();
+        maxs.clear();
+        const uint32_t boxCount = 1 + random.NextBelow(s_maxBoxes);
+        for (uint32_t box = 0; box < boxCount; ++box) {
+            const glm::vec3 min(RandomIn(random, -20, 20), RandomIn(random, -20, 20), RandomIn(random, -20, 20));
+            const glm::vec3 size(RandomIn(random, 0, 5), RandomIn(random, 0, 5), RandomIn(random, 0, 5));
+            mins.push_back(min);
+            maxs.push_back(min + size);
+            batch.Add(min, min + size);
+        }
+
+        // Promien celuje w okolice losowego pudelka, zeby trafienia nie byly rzadkie. Zerowe skladowe
+        // kierunku daja nieskonczone odwrotnosci, ktore SIMD musi traktowac tak samo
+        const glm::vec3 origin(RandomIn(random, -25, 25), RandomIn(random, -25, 25), RandomIn(random, -25, 25));
+        const size_t target = random.NextBelow(boxCount);
+        const glm::vec3 jitter(RandomIn(random, -3, 3), RandomIn(random, -3, 3), RandomIn(random, -3, 3));
+        glm::vec3 direction = (mins[target] + maxs[target]) * 0.5f + jitter - origin;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (random.NextBelow(4) == 0) {
+                direction[axis] = 0.0f;
+            }
+        }
+        if (direction == glm::vec3(0.0f)) {
+            direction.y = -1.0f;
+        }
+        const Ray ray(origin, glm::normalize(direction));
+        const Ray::time_t maxTime = RandomIn(random, 1, 60);
+
+        AABBBatch::HitRecord simd{};
+        AABBBatch::HitRecord scalar{};
+        const Ray::HitType simdType = batch.Hit(ray, 0, maxTime, simd);
+        const Ray::HitType scalarType = batch.HitScalar(ray, 0, maxTime, scalar);
+        if (simdType != scalarType || (simdType == Ray::HitType::Hit && (simd.m_index != scalar.m_index
+            || std::memcmp(&simd.m_time, &scalar.m_time, sizeof(Ray::time_t)) != 0 || simd.m_axis != scalar.m_axis))) {
+            std::cerr << "AABBBatch::Hit differs from HitScalar in case " << i << std::endl;
+            ++mismatches;
+        }
+
+        const glm::vec3 eye(RandomIn(random, -30, 30), RandomIn(random, -30, 30), RandomIn(random, -30, 30));
+        const float yaw = glm::radians(RandomIn(random, 0, 360));
+        const float pitch = glm::radians(RandomIn(random, -80, 80));
+        const glm::vec3 front(std::cos(yaw) * std::cos(pitch), std::sin(pitch), std::sin(yaw) * std::cos(pitch));
+        const glm::mat4 projection = glm::perspective(glm::radians(RandomIn(random, 30, 100)),
+            RandomIn(random, 1, 2.5f), 0.1f, RandomIn(random, 10, 100));
+        const Frustum frustum(projection * glm::lookAt(eye, eye + front, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        size_t visibleCount = 0;
+        for (size_t box = 0; box < boxCount; ++box) {
+            visibleCount += frustum.Intersects(mins[box], maxs[box]) ? 1 : 0;
+        }
+        const size_t culledCount = batch.Cull(frustum, visible);
+        bool isCullMatching = culledCount == visibleCount;
+        for (size_t box = 0; box < boxCount && isCullMatching; ++box) {
+            isCullMatching = (visible[box] != 0) == frustum.Intersects(mins[box], maxs[box]);
+        }
+        if (!isCullMatching) {
+            std::cerr << "AABBBatch::Cull differs from Frustum::Intersects in case " << i << std::endl;
+            ++mismatches;
+        }
+    }
+
+    std::cerr << "AABBBatch checks: " << s_caseCount << " cases, " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+void RunNoiseBenchmarks(const PerlinNoise& perlin, Runner& runner) {
+    // 16 x 16 x 16 probek na wywolanie, w obu wariantach ta sama siatka
+    constexpr int s_gridSize = 16;
+    constexpr uint64_t s_samples = static_cast<uint64_t>(s_gridSize) * s_gridSize * s_gridSize;
+    const glm::vec3 step(0.0371f);
+    std::vector<float> out(s_samples);
+
+    runner.Measure("PerlinNoise::At", "16^3", s_samples, 0, [&](size_t iteration) {
+        const glm::vec3 origin(static_cast<float>(iteration % 1024) * 0.61f, 0.0f, 0.0f);
+        float* sample = out.data();
+        for (int y = 0; y < s_gridSize; ++y) {
+            for (int x = 0; x < s_gridSize; ++x) {
+                for (int z = 0; z < s_gridSize; ++z) {
+                    *sample++ = perlin.At(origin + step * glm::vec3(x, y, z));
+                }
+            }
+        }
+        });
+    runner.Measure("PerlinNoise::Fill", "16^3", s_samples, 0, [&](size_t iteration) {
+        const glm::vec3 origin(static_cast<float>(iteration % 1024) * 0.61f, 0.0f, 0.0f);
+        perlin.Fill(origin, step, glm::ivec3(s_gridSize), out.data());
+        });
+}
+
+/** Per chunk benchmarks for one chunk size. Generate includes visibility, it is also measured alone. */
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+void RunChunkBenchmarks(const TerrainGenerator& generator, Runner& runner) {
+    using Chunk_t = Chunk<Depth, Width, Height>;
+    constexpr uint64_t s_volume = static_cast<uint64_t>(Depth) * Width * Height;
+    constexpr size_t s_rayCount = 1024;
+    const std::string config = std::to_string(Width) + "x" + std::to_string(Depth) + "x" + std::to_string(Height);
+
+    // Kolejne wywolania generuja rozne chunki z kwadratu 8 x 8, jak przy chodzeniu po swiecie
+    auto originOf = [](size_t iteration) {
+        return glm::vec2(static_cast<float>(iteration % 8 * Width), static_cast<float>(iteration / 8 % 8 * Depth));
+    };
+
+    auto chunk = std::make_unique<Chunk_t>(originOf(0));
+    runner.Measure("Chunk::Generate", config, 1, s_volume, [&](size_t iteration) {
+        chunk->Reset(originOf(iteration));
+        chunk->Generate(generator);
+        });
+
+    chunk->Reset(originOf(0));
+    chunk->Generate(generator);
+    runner.Measure("Chunk::UpdateVisibility", config, 1, s_volume, [&](size_t) {
+        chunk->UpdateVisibility();
+        });
+
+    ChunkMeshData mesh;
+    runner.Measure("Chunk::BuildMesh", config, 1, s_volume, [&](size_t) {
+        for (size_t section = 0; section < Chunk_t::s_sectionCount; ++section) {
+            chunk->BuildMesh(section, mesh);
+        }
+        });
+
+    SplitMix64 random(7);
+    std::vector<Ray> rays;
+    rays.reserve(s_rayCount);
+    for (size_t i = 0; i < s_rayCount; ++i) {
+        const glm::vec3 origin(random.NextBelow(Width) + 0.5f, Height + 1.0f, random.NextBelow(Depth) + 0.5f);
+        rays.emplace_back(origin, DownwardDirection(random));
+    }
+    size_t hits = 0;
+    runner.Measure("Chunk::Hit", config, s_rayCount, 0, [&](size_t) {
+        typename Chunk_t::HitRecord record;
+        for (const Ray& ray : rays) {
+            hits += chunk->Hit(ray, 0.0f, std::numeric_limits<Ray::time_t>::infinity(), record) == Ray::HitType::Hit;
+        }
+        });
+    if (hits == 0 && runner.IsEnabled("Chunk::Hit")) {
+        std::cerr << "Chunk::Hit " << config << ": no ray hit the terrain" << std::endl;
+    }
+}
+
+/** Loading of the whole render distance window through the job queue (generation, visibility
+ * and meshing on the workers) and world ray casts across the loaded chunks.
+ */
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+void RunWorldBenchmarks(const TerrainGenerator& generator, int renderDistance, Runner& runner) {
+    using ChunkManager_t = ChunkManager<Depth, Width, Height>;
+    constexpr uint64_t s_volume = static_cast<uint64_t>(Depth) * Width * Height;
+    constexpr size_t s_rayCount = 1024;
+    const std::string config = std::to_string(Width) + "x" + std::to_string(Depth) + "x"
+        + std::to_string(Height) + "/r" + std::to_string(renderDistance);
+
+    const size_t windowSize = static_cast<size_t>(2 * renderDistance + 1) * (2 * renderDistance + 1);
+    const size_t workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    JobQueue jobQueue(workerCount, windowSize);
+    const glm::vec3 center(Width * 0.5f, Height * 0.75f, Depth * 0.5f);
+
+    auto load = [&](ChunkManager_t& chunkManager) {
+        while (chunkManager.Size() < chunkManager.Capacity()) {
+            chunkManager.Update(center);
+            std::this_thread::yield();
+        }
+    };
+
+    runner.Measure("ChunkManager::Load", config, windowSize, windowSize * s_volume, [&](size_t) {
+        ChunkManager_t chunkManager(generator, jobQueue, renderDistance);
+        load(chunkManager);
+        });
+
+    if (!runner.IsEnabled("ChunkManager::Raycast")) {
+        return;
+    }
+    ChunkManager_t chunkManager(generator, jobQueue, renderDistance);
+    load(chunkManager);
+
+    // Promienie w dol pod roznymi katami, jak przy celowaniu w teren z wysokosci
+    SplitMix64 random(11);
+    std::vector<Ray> rays;
+    rays.reserve(s_rayCount);
+    for (size_t i = 0; i < s_rayCount; ++i) {
+        rays.emplace_back(center, DownwardDirection(random));
+    }
+    const Ray::time_t maxTime = static_cast<Ray::time_t>(renderDistance * std::max<int>(Width, Depth));
+    size_t hits = 0;
+    runner.Measure("ChunkManager::Raycast", config, s_rayCount, 0, [&](size_t) {
+        typename ChunkManager_t::RaycastHit hit;
+        for (const Ray& ray : rays) {
+            hits += chunkManager.Raycast(ray, maxTime, hit);
+        }
+        });
+    if (hits == 0) {
+        std::cerr << "ChunkManager::Raycast " << config << ": no ray hit the terrain" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const Options options = ParseOptions(argc, argv);
+    PerlinNoise perlin(options.m_seed);
+    TerrainGenerator generator(perlin);
+    Runner runner(options);
+
+    if (RunBatchChecks(options.m_seed) != 0) {
+        return 1;
+    }
+
+    RunNoiseBenchmarks(perlin, runner);
+
+    RunChunkBenchmarks<16, 16, 64>(generator, runner);
+    RunChunkBenchmarks<16, 16, 128>(generator, runner);
+    RunChunkBenchmarks<32, 32, 128>(generator, runner);
+
+    for (int renderDistance : { 2, 4, 8 }) {
+        RunWorldBenchmarks<16, 16, 64>(generator, renderDistance, runner);
+    }
+
+    runner.Print(std::cout);
+    return 0;
+}
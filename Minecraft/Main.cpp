@@ -9,69 +9,39 @@
 #include <Camera.h>
 #include <CubePalette.h>
 #include <Chunk.h>
+#include <ChunkManager.h>
 #include <random>
 #include <memory>
 #include <functional> 
+#include <thread>
+#include <JobQueue.h>
+#include <AllocationStats.h>
+#include <PlayerBody.h>
+#include <Simulation.h>
+#include <TerrainGenerator.h>
+#include <WorldStorage.h>
+#include <GLHelpers.h>
+#include <Frustum.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <optional>
+#include <filesystem>
+#include <string>
+#include <vector>
 
 
-namespace std {
-    template <>
-    struct hash<glm::ivec2> {
-        size_t operator()(const glm::ivec2& v) const noexcept {
-            size_t h1 = std::hash<int>()(v.x);
-            size_t h2 = std::hash<int>()(v.y);
-            return h1 ^ (h2 * 0x9e3779b9 + (h1 << 6) + (h1 >> 2)); 
-        }
-    };
-}
-
 const size_t chunkSize = 16;
+const size_t chunkHeight = 64;
 const int renderDistance = 4; 
+const float tickTime = 1.0f / 60.0f;   // stały krok symulacji
+const glm::vec3 playerSize(0.6f, 1.8f, 0.6f);
+const float eyeHeight = 1.62f;
 
-std::unordered_map<glm::ivec2, std::unique_ptr<Chunk<chunkSize, chunkSize, chunkSize>>> chunks;
-
-
-void UpdateChunks(const glm::vec3& playerPosition, CubePalette& palette, const PerlinNoise& perlin) {
-    glm::ivec2 playerChunk = glm::ivec2(static_cast<int>(std::floor(playerPosition.x / chunkSize)),
-        static_cast<int>(std::floor(playerPosition.z / chunkSize)));
-    int playerChunkX = static_cast<int>(playerPosition.x) / chunkSize;
-    int playerChunkZ = static_cast<int>(playerPosition.z) / chunkSize;
-    
-    std::unordered_map<glm::ivec2, std::unique_ptr<Chunk<chunkSize, chunkSize, chunkSize>>> newChunks;
-
-    for (int dx = playerChunkX-renderDistance; dx <= playerChunkX + renderDistance; ++dx) {
-        for (int dz = playerChunkZ - renderDistance; dz <= playerChunkZ + renderDistance; ++dz) {
-            glm::ivec2 chunkPos = glm::ivec2(dx, dz);
-
-            if (chunks.find(chunkPos) != chunks.end()) {
-                // Używamy std::move(), aby przenieść wskaźnik na chunk do nowej mapy
-                newChunks[chunkPos] = std::move(chunks[chunkPos]);
-            }
-            else {
-                // Tworzymy nowy wskaźnik do chunku
-				
-                //std::cout << "Player chunk: " << playerChunk.x << ", " << playerChunk.y << std::endl;
-                //std::cout << "Generating chunk at: " << chunkPos.x << ", " << chunkPos.y << std::endl;
-                auto chunk = std::make_unique<Chunk<chunkSize, chunkSize, chunkSize>>(
-                    glm::ivec2(chunkPos.x * chunkSize, chunkPos.y * chunkSize), palette);
-                chunk->Generate(perlin);
-                newChunks.emplace(chunkPos, std::move(chunk));
-            }
-        }
-    }
-    // Zastępujemy starą mapę nową, usuwając niepotrzebne chunki
-    chunks.clear();  // Usuwamy stare chunki
-    for (auto& [pos, chunk] : newChunks) {
-        //std::cout << "Existing chunk at: " << pos.x << ", " << pos.y << std::endl;
-        chunks[pos] = std::move(chunk);  
-    }
-}
-
-void DrawChunks(ShaderProgram& shader) {
-    for (auto& [pos, chunk] : chunks) {
-        chunk->Draw(shader);  
-    }
-}
+using ChunkManager_t = ChunkManager<chunkSize, chunkSize, chunkHeight>;
+using Chunk_t = ChunkManager_t::Chunk_t;
+using Simulation_t = Simulation<ChunkManager_t>;
 
 
 
@@ -116,77 +86,136 @@ unsigned int crosshairIndices[] = {
 };
 
 
-// Linkowanie programu
-GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = 0)
-{
-    const GLuint programId = glCreateProgram();
-    if (!programId) {
-        std::cerr << "Error creating shader program " << std::endl;
-        return 0;   // null handle 
-    }
-
-    glAttachShader(programId, vertexShader);
-    glAttachShader(programId, fragmentShader);
-    if (geometryShader) glAttachShader(programId, geometryShader);
-
-    glLinkProgram(programId);
+/** Command line: [--headless [ticks]] [--seed number] [--world directory]. */
+struct Options {
+    bool m_isHeadless{ false };
+    size_t m_tickCount{ 36000 };
+    std::optional<uint64_t> m_seed;
+    std::optional<std::filesystem::path> m_worldPath;
+};
 
-    return programId;
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            options.m_isHeadless = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                options.m_tickCount = std::strtoull(argv[++i], nullptr, 10);
+            }
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.m_seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--world") == 0 && i + 1 < argc) {
+            options.m_worldPath = argv[++i];
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+        }
+    }
+    return options;
 }
 
-// Kompilacja shaderów
-GLuint CreateShader(const GLchar* shaderSource, GLenum shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    if (!shaderId) {
-        std::cerr << "Error creating shader! (shaderId do not exists)" << std::endl;
-        return 0;   // null handle 
+/** FNV-1a hash of the block types of the columns around the world origin. The same seed must
+ * give the same checksum on every machine, so benchmark runs can be checked to use the same world.
+ */
+uint64_t WorldChecksum(const TerrainGenerator& generator) {
+    std::vector<Cube::Type> types(chunkSize * chunkSize * chunkHeight);
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (int x = -2; x < 2; ++x) {
+        for (int z = -2; z < 2; ++z) {
+            generator.Generate(glm::ivec3(x * static_cast<int>(chunkSize), 0, z * static_cast<int>(chunkSize)),
+                glm::ivec3(chunkSize, chunkHeight, chunkSize), types.data());
+            for (Cube::Type type : types) {
+                hash = (hash ^ static_cast<uint8_t>(type)) * 0x100000001B3ull;
+            }
+        }
     }
+    return hash;
+}
 
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
-
-    // error handling 
-    GLint success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        std::cerr << "Shader compilation failed" << std::endl;
-        return 0;
+/** Prints average time per chunk column spent in every terrain generation stage. */
+void PrintTerrainTimings(const TerrainGenerator& generator) {
+    const TerrainGenerator::Timings timings = generator.GetTimings();
+    const double columns = static_cast<double>(std::max<uint64_t>(timings.m_columns, 1));
+    std::cout << "Terrain: " << timings.m_columns << " columns, us/column:";
+    for (size_t stage = 0; stage < TerrainGenerator::s_stageCount; ++stage) {
+        std::cout << " " << TerrainGenerator::StageName(static_cast<TerrainGenerator::Stage>(stage))
+            << " " << timings.m_nanoseconds[stage] / columns / 1000.0;
     }
-
-    return shaderId;
+    std::cout << std::endl;
 }
 
-// Tworzenie tekstury
-GLuint CreateTexture(const std::string& path) {
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    sf::Image image;
-    if (image.loadFromFile(path)) {
-        image.flipVertically();
-        const sf::Vector2u size = image.getSize();
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getPixelsPtr());
-        glGenerateMipmap(GL_TEXTURE_2D);
+/** Runs the simulation without a window: the player walks in slowly turning circles, jumping all the time,
+ * chunks stream in and out around it. Ticks run as fast as possible, but wait for the chunks
+ * around the player to be generated. Prints simulation throughput (without the waiting),
+ * chunk and allocation statistics.
+ */
+int RunHeadless(const Options& options) {
+    const size_t tickCount = options.m_tickCount;
+    const uint64_t seed = options.m_seed.value_or(12345);
+    PerlinNoise perlin(seed);
+    TerrainGenerator generator(perlin);
+    std::cout << "Seed: " << seed << ", world checksum: " << std::hex << WorldChecksum(generator)
+        << std::dec << std::endl;
+    generator.ResetTimings();
+    const size_t workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    JobQueue jobQueue(workerCount, (2 * renderDistance + 1) * (2 * renderDistance + 1));
+    // Bez --world swiat nie jest zapisywany, zeby kolejne przebiegi byly porownywalne
+    std::optional<WorldStorage> storage;
+    if (options.m_worldPath) {
+        storage.emplace(*options.m_worldPath);
     }
-    else {
-        std::cerr << "Failed to load texture: " << path << std::endl;
+    ChunkManager_t chunkManager(generator, jobQueue, renderDistance, storage ? &*storage : nullptr);
+    Simulation_t simulation(chunkManager, PlayerBody(glm::vec3(9.0f, 60.0f, 6.0f), playerSize), tickTime);
+
+    const AllocationStats allocationsBefore = AllocationStats::Current();
+    std::chrono::steady_clock::duration tickDuration{ 0 };
+    std::chrono::steady_clock::duration waitDuration{ 0 };
+
+    for (size_t tick = 0; tick < tickCount; ++tick) {
+        const auto waitStart = std::chrono::steady_clock::now();
+        while (!chunkManager.IsLoadedAround(simulation.GetPlayer().GetPosition())) {
+            chunkManager.Update(simulation.GetPlayer().GetPosition());
+            std::this_thread::yield();
+        }
+        const auto tickStart = std::chrono::steady_clock::now();
+        waitDuration += tickStart - waitStart;
+
+        const float angle = tick * 0.002f;
+        Simulation_t::Input input;
+        input.m_walk = glm::vec2(std::cos(angle), std::sin(angle)) * 4.3f;
+        input.m_isJumping = true;
+        simulation.Tick(input);
+        tickDuration += std::chrono::steady_clock::now() - tickStart;
     }
 
-    return texture;
+    const double seconds = std::chrono::duration<double>(tickDuration).count();
+    const double waitSeconds = std::chrono::duration<double>(waitDuration).count();
+    const AllocationStats allocations = AllocationStats::Current() - allocationsBefore;
+    const ChunkManager_t::Stats& chunkStats = chunkManager.GetStats();
+    const glm::vec3 position = simulation.GetPlayer().GetPosition();
+
+    std::cout << "Ticks: " << tickCount << " (" << tickCount * tickTime << " s simulated) in "
+        << seconds << " s, " << tickCount / seconds << " ticks/s, "
+        << waitSeconds << " s waiting for chunks" << std::endl;
+    std::cout << "Player: (" << position.x << ", " << position.y << ", " << position.z << ")" << std::endl;
+    std::cout << "Chunks: " << chunkManager.Size() << "/" << chunkManager.Capacity()
+        << " loaded, " << chunkStats.m_createdChunks << " created, "
+        << chunkStats.m_recycledChunks << " recycled, "
+        << chunkStats.m_cancelledJobs << " cancelled" << std::endl;
+    std::cout << "Heap: " << allocations.m_allocations << " allocations ("
+        << allocations.m_allocatedBytes << " bytes)" << std::endl;
+    PrintTerrainTimings(generator);
+    return 0;
 }
 
-
-
-
-
-int main() {
+int main(int argc, char* argv[]) {
+    // --headless [ticks] - sama symulacja, bez okna i OpenGL; bez --seed headless uzywa stalego ziarna
+    const Options options = ParseOptions(argc, argv);
+    if (options.m_isHeadless) {
+        return RunHeadless(options);
+    }
 
     sf::ContextSettings contextSettings;
     contextSettings.depthBits = 24;
@@ -214,7 +243,7 @@ int main() {
         static_cast<GLsizei>(window.getSize().y));
     glEnable(GL_DEPTH_TEST);
 
-    Camera camera(glm::vec3(9.0f, 3.0f, 6.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+    Camera camera(glm::vec3(9.0f, 60.0f, 6.0f), glm::vec3(0.0f, 0.0f, -1.0f),
         -90.0f, 0.0f);
 
     // Tworzenie shaderów
@@ -226,17 +255,23 @@ int main() {
 
     CubePalette palette;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(10000, 99999);
-    int random_number = dis(gen);
-    std::cout << random_number << "\n";
-    PerlinNoise perlin(static_cast<int>(random_number));
+    // Losowe ziarno tylko gdy nie podano --seed; wypisujemy je, zeby swiat mozna bylo odtworzyc
+    const uint64_t seed = options.m_seed ? *options.m_seed : std::random_device()();
+    std::cout << "Seed: " << seed << std::endl;
+    PerlinNoise perlin(seed);
+    TerrainGenerator generator(perlin);
+
+    // Generowanie chunków w tle, wątek główny tylko wysyła gotowe siatki na GPU
+    const size_t workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    JobQueue jobQueue(workerCount, (2 * renderDistance + 1) * (2 * renderDistance + 1));
+    // Kazde ziarno ma osobny katalog z zapisanymi chunkami
+    WorldStorage storage(options.m_worldPath.value_or(std::filesystem::path("worlds") / std::to_string(seed)));
+    ChunkManager_t chunkManager(generator, jobQueue, renderDistance, &storage);
 
     
 
     //Ray::HitType hitType;
-    Chunk<chunkSize, chunkSize, chunkSize>::HitRecord hitRecord;
+    ChunkManager_t::RaycastHit hitRecord;
 
 
 
@@ -304,9 +339,17 @@ int main() {
     sf::Vector2i windowCenter(window.getSize().x / 2, window.getSize().y / 2);
     sf::Vector2i lastMousePosition = sf::Mouse::getPosition(window);
 
+    AllocationStats lastAllocationStats = AllocationStats::Current();
+    sf::Clock statsClock;
+
 
     bool isMousePressed = false; // Zmienna stanu kliknięcia
 
+    // Gracz z fizyką; F przełącza na swobodny lot bez kolizji
+    Simulation_t simulation(chunkManager,
+        PlayerBody(camera.GetPosition() - glm::vec3(0.0f, eyeHeight, 0.0f), playerSize), tickTime);
+    bool isFlying = false;
+
 
     
 
@@ -321,29 +364,67 @@ int main() {
             else if (event.type == sf::Event::Resized)
                 glViewport(0, 0, event.size.width, event.size.height);
 
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F) {
+                isFlying = !isFlying;
+            }
+
+            // F3 - statystyki chunków i alokacji od poprzedniego wciśnięcia
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                const AllocationStats allocationStats = AllocationStats::Current();
+                const AllocationStats delta = allocationStats - lastAllocationStats;
+                const ChunkManager_t::Stats& chunkStats = chunkManager.GetStats();
+                std::cout << "Chunks: " << chunkManager.Size() << "/" << chunkManager.Capacity()
+                    << " loaded, " << chunkStats.m_createdChunks << " created, "
+                    << chunkStats.m_recycledChunks << " recycled, "
+                    << chunkStats.m_cancelledJobs << " cancelled, " << chunkStats.m_meshJobs << " mesh jobs" << std::endl;
+
+                size_t typesMemory = 0;
+                chunkManager.ForEach([&](const glm::ivec2&, Chunk_t& chunk) {
+                    typesMemory += chunk.TypesMemoryUsage();
+                    });
+                std::cout << "Cube types: " << typesMemory << " bytes" << std::endl;
+                const ChunkManager_t::FrameStats& frameStats = chunkManager.GetFrameStats();
+                std::cout << "Culling: " << frameStats.m_culledChunks << "/" << frameStats.m_testedChunks
+                    << " chunks, " << frameStats.m_culledSections << "/" << frameStats.m_testedSections
+                    << " sections culled, " << frameStats.m_draws << " draws in " << frameStats.m_drawCalls
+                    << " calls in the last frame" << std::endl;
+                const MeshBuffer::Stats& meshStats = frameStats.m_meshBuffer;
+                std::cout << "Mesh buffer: " << meshStats.m_usedVertices << "/" << meshStats.m_capacity
+                    << " vertices, " << meshStats.m_freeBlocks << " free blocks, largest "
+                    << meshStats.m_largestFreeBlock << ", fragmentation " << meshStats.Fragmentation()
+                    << ", " << meshStats.m_uploads << " uploads (" << meshStats.m_uploadedBytes << " bytes, "
+                    << meshStats.m_uploadNanoseconds / 1000.0 << " us), " << meshStats.m_fenceWaits
+                    << " fence waits in the last frame" << (meshStats.m_isPersistent ? ", persistent" : "")
+                    << (meshStats.m_isIndirect ? ", multi-draw indirect" : "") << std::endl;
+                PrintTerrainTimings(generator);
+                const WorldStorage::Stats storageStats = storage.GetStats();
+                std::cout << "Storage: " << storageStats.m_journalEdits << " journaled edits ("
+                    << storageStats.m_journalRecords << " records in file), " << chunkStats.m_snapshots
+                    << " snapshots, " << storageStats.m_savedChunks << " written ("
+                    << storageStats.m_savedBytes << " bytes), " << storageStats.m_loadedChunks << " loaded, "
+                    << storageStats.m_failedWrites << " failed writes" << std::endl;
+                std::cout << "Heap: " << delta.m_allocations << " allocations ("
+                    << delta.m_allocatedBytes << " bytes), " << delta.m_deallocations
+                    << " deallocations in " << statsClock.restart().asSeconds() << " s" << std::endl;
+                lastAllocationStats = AllocationStats::Current();
+            }
+
             if (event.type == sf::Event::MouseButtonPressed) {
                 Ray ray(camera.GetPosition(), camera.GetFront());
-                for (auto& [pos, chunk] : chunks) {
-                    Ray::HitType hitType = chunk->Hit(ray, 0.0f, 3.0f, hitRecord);  // ✅ Używamy -> zamiast .  
-                    if (hitType == Ray::HitType::Hit) {
-                        std::cout << "Hit block at: (" << hitRecord.m_cubeIndex.x << ", "
-                            << hitRecord.m_cubeIndex.y << ", "
-                            << hitRecord.m_cubeIndex.z << ")" << std::endl;
+                if (chunkManager.Raycast(ray, 3.0f, hitRecord)) {
+                    std::cout << "Hit block at: (" << hitRecord.m_block.x << ", "
+                        << hitRecord.m_block.y << ", "
+                        << hitRecord.m_block.z << ")" << std::endl;
 
-                        if (event.type == sf::Event::MouseButtonPressed && !isMousePressed) {
-                            isMousePressed = true; // Rejestruj kliknięcie myszy  
+                    if (event.type == sf::Event::MouseButtonPressed && !isMousePressed) {
+                        isMousePressed = true; // Rejestruj kliknięcie myszy  
 
-                            if (event.mouseButton.button == sf::Mouse::Left) {
-                                chunk->RemoveBlock(hitRecord.m_cubeIndex.x,
-                                    hitRecord.m_cubeIndex.y,
-                                    hitRecord.m_cubeIndex.z);
-                            }
-                            else if (event.mouseButton.button == sf::Mouse::Right) {
-                                chunk->PlaceBlock(hitRecord.m_neighbourIndex.x,
-                                    hitRecord.m_neighbourIndex.y,
-                                    hitRecord.m_neighbourIndex.z,
-                                    Cube::Type::Grass);
-                            }
+                        if (event.mouseButton.button == sf::Mouse::Left) {
+                            chunkManager.RemoveBlock(hitRecord.m_block);
+                        }
+                        else if (event.mouseButton.button == sf::Mouse::Right) {
+                            chunkManager.PlaceBlock(hitRecord.m_block + hitRecord.m_normal,
+                                Cube::Type::Grass);
                         }
                     }
                 }
@@ -384,15 +465,39 @@ int main() {
 
 
 
-        float movementSpeed = 0.1f;
-        // Obsługa klawiatury
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) camera.MoveForward(dt + movementSpeed);
-        if ((sf::Keyboard::isKeyPressed(sf::Keyboard::W)) && (sf::Keyboard::isKeyPressed(sf::Keyboard::LControl))) camera.MoveForward(dt + movementSpeed);
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) camera.MoveBackward(dt + movementSpeed);
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) camera.MoveLeft(dt + movementSpeed);
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) camera.MoveRight(dt + movementSpeed);
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) camera.MoveUp(dt + movementSpeed);
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift)) camera.MoveDown(dt + movementSpeed);
+        if (isFlying) {
+            // Prędkość w blokach na sekundę, niezależna od liczby klatek
+            const float movementSpeed = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) ? 20.0f : 10.0f;
+            // Obsługa klawiatury
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) camera.MoveForward(dt * movementSpeed);
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) camera.MoveBackward(dt * movementSpeed);
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) camera.MoveLeft(dt * movementSpeed);
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) camera.MoveRight(dt * movementSpeed);
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space)) camera.MoveUp(dt * movementSpeed);
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift)) camera.MoveDown(dt * movementSpeed);
+            simulation.Teleport(camera.GetPosition() - glm::vec3(0.0f, eyeHeight, 0.0f));
+        }
+        else {
+            const float walkSpeed = sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) ? 5.6f : 4.3f;
+
+            // Kierunek ruchu w płaszczyźnie poziomej
+            glm::vec2 forward(camera.GetFront().x, camera.GetFront().z);
+            glm::vec2 right(camera.GetRight().x, camera.GetRight().z);
+            forward = glm::length(forward) > 0.0f ? glm::normalize(forward) : glm::vec2(0.0f);
+            right = glm::length(right) > 0.0f ? glm::normalize(right) : glm::vec2(0.0f);
+
+            Simulation_t::Input input;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)) input.m_walk += forward;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)) input.m_walk -= forward;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::A)) input.m_walk -= right;
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::D)) input.m_walk += right;
+            if (glm::length(input.m_walk) > 0.0f) input.m_walk = glm::normalize(input.m_walk) * walkSpeed;
+            input.m_isJumping = sf::Keyboard::isKeyPressed(sf::Keyboard::Space);
+
+            // Symulacja w stałych krokach, kamera interpolowana między dwoma ostatnimi krokami
+            simulation.Advance(dt, input);
+            camera.SetPosition(simulation.InterpolatedPosition() + glm::vec3(0.0f, eyeHeight, 0.0f));
+        }
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Escape)) window.close(); //Escape do zamknięcia
         //if (sf::Mouse::isButtonPressed(sf::Mouse::Left));
 
@@ -402,7 +507,6 @@ int main() {
         sf::Vector2i mouseDelta = mousePosition - lastMousePosition;
         camera.Rotate(mouseDelta);
         lastMousePosition = mousePosition;
-        UpdateChunks(camera.GetPosition(), palette, perlin);
         // Czyszczenie ekranu
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -420,7 +524,7 @@ int main() {
         //chunk.Draw(shaders);
 
         
-        DrawChunks(shaders);
+        chunkManager.Draw(shaders, palette, Frustum(camera.Projection() * camera.View()));
        /* for (auto& chunk : chunks) {
             chunk.Draw(shaders);
         }*/
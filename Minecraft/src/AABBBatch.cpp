@@ -0,0 +1,242 @@
+#include "AABBBatch.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define AABB_BATCH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AABB_BATCH_SSE
+#endif
+
+namespace {
+	constexpr size_t s_npos = static_cast<size_t>(-1);
+
+	// Ta sama semantyka co _mm_min_ps / _mm_max_ps, rowniez dla NaN (zwracany jest drugi argument)
+	inline float Min(float a, float b) { return a < b ? a : b; }
+	inline float Max(float a, float b) { return a > b ? a : b; }
+
+	inline void Select(size_t index, float enter, Ray::time_t& closestTime, size_t& closestIndex) {
+		if (closestIndex == s_npos || enter < closestTime) {
+			closestTime = enter;
+			closestIndex = index;
+		}
+	}
+}
+
+void AABBBatch::Clear() {
+	m_minX.clear(); m_minY.clear(); m_minZ.clear();
+	m_maxX.clear(); m_maxY.clear(); m_maxZ.clear();
+}
+
+void AABBBatch::Reserve(size_t count) {
+	m_minX.reserve(count); m_minY.reserve(count); m_minZ.reserve(count);
+	m_maxX.reserve(count); m_maxY.reserve(count); m_maxZ.reserve(count);
+}
+
+void AABBBatch::Add(const glm::vec3& min, const glm::vec3& max) {
+	m_minX.push_back(min.x); m_minY.push_back(min.y); m_minZ.push_back(min.z);
+	m_maxX.push_back(max.x); m_maxY.push_back(max.y); m_maxZ.push_back(max.z);
+}
+
+Ray::HitType AABBBatch::Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const {
+	const glm::vec3 origin = ray.Origin();
+	const glm::vec3 inverse = glm::vec3(1.0f) / ray.Direction();
+
+	Ray::time_t closestTime = maxTime;
+	size_t closestIndex = s_npos;
+	size_t index = 0;
+
+#if defined(AABB_BATCH_AVX)
+	const __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+	const __m256 ix = _mm256_set1_ps(inverse.x), iy = _mm256_set1_ps(inverse.y), iz = _mm256_set1_ps(inverse.z);
+	const __m256 tMin = _mm256_set1_ps(minTime);
+	alignas(32) float enterLanes[8];
+
+	for (; index + 8 <= Size(); index += 8) {
+		const __m256 x0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_minX[index]), ox), ix);
+		const __m256 x1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_maxX[index]), ox), ix);
+		const __m256 y0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_minY[index]), oy), iy);
+		const __m256 y1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_maxY[index]), oy), iy);
+		const __m256 z0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_minZ[index]), oz), iz);
+		const __m256 z1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&m_maxZ[index]), oz), iz);
+
+		const __m256 enter = _mm256_max_ps(_mm256_max_ps(_mm256_max_ps(
+			_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)), _mm256_min_ps(z0, z1)), tMin);
+		const __m256 exit = _mm256_min_ps(_mm256_min_ps(
+			_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)), _mm256_max_ps(z0, z1));
+
+		const __m256 hit = _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ),
+			_mm256_cmp_ps(enter, _mm256_set1_ps(closestTime), _CMP_LE_OQ));
+		int mask = _mm256_movemask_ps(hit);
+		if (mask) {
+			// Kandydatow sprawdzamy po kolei, tak jak HitScalar, zeby remisy rozstrzygac identycznie
+			_mm256_store_ps(enterLanes, enter);
+			for (size_t lane = 0; mask; ++lane, mask >>= 1) {
+				if (mask & 1) {
+					Select(index + lane, enterLanes[lane], closestTime, closestIndex);
+				}
+			}
+		}
+	}
+#elif defined(AABB_BATCH_SSE)
+	const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+	const __m128 ix = _mm_set1_ps(inverse.x), iy = _mm_set1_ps(inverse.y), iz = _mm_set1_ps(inverse.z);
+	const __m128 tMin = _mm_set1_ps(minTime);
+	alignas(16) float enterLanes[4];
+
+	for (; index + 4 <= Size(); index += 4) {
+		const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minX[index]), ox), ix);
+		const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxX[index]), ox), ix);
+		const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minY[index]), oy), iy);
+		const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxY[index]), oy), iy);
+		const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_minZ[index]), oz), iz);
+		const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_maxZ[index]), oz), iz);
+
+		const __m128 enter = _mm_max_ps(_mm_max_ps(_mm_max_ps(
+			_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_min_ps(z0, z1)), tMin);
+		const __m128 exit = _mm_min_ps(_mm_min_ps(
+			_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_max_ps(z0, z1));
+
+		const __m128 hit = _mm_and_ps(_mm_cmple_ps(enter, exit),
+			_mm_cmple_ps(enter, _mm_set1_ps(closestTime)));
+		int mask = _mm_movemask_ps(hit);
+		if (mask) {
+			// Kandydatow sprawdzamy po kolei, tak jak HitScalar, zeby remisy rozstrzygac identycznie
+			_mm_store_ps(enterLanes, enter);
+			for (size_t lane = 0; mask; ++lane, mask >>= 1) {
+				if (mask & 1) {
+					Select(index + lane, enterLanes[lane], closestTime, closestIndex);
+				}
+			}
+		}
+	}
+#endif
+
+	// Pozostale pudelka (albo wszystkie, bez SSE) liczymy skalarnie
+	HitRange(index, Size(), origin, inverse, minTime, closestTime, closestIndex);
+
+	if (closestIndex == s_npos) {
+		return Ray::HitType::Miss;
+	}
+
+	record.m_index = closestIndex;
+	record.m_time = closestTime;
+	record.m_axis = EntryAxis(closestIndex, origin, inverse);
+	return Ray::HitType::Hit;
+}
+
+Ray::HitType AABBBatch::HitScalar(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const {
+	const glm::vec3 origin = ray.Origin();
+	const glm::vec3 inverse = glm::vec3(1.0f) / ray.Direction();
+
+	Ray::time_t closestTime = maxTime;
+	size_t closestIndex = s_npos;
+	HitRange(0, Size(), origin, inverse, minTime, closestTime, closestIndex);
+
+	if (closestIndex == s_npos) {
+		return Ray::HitType::Miss;
+	}
+
+	record.m_index = closestIndex;
+	record.m_time = closestTime;
+	record.m_axis = EntryAxis(closestIndex, origin, inverse);
+	return Ray::HitType::Hit;
+}
+
+void AABBBatch::HitRange(size_t first, size_t last, const glm::vec3& origin, const glm::vec3& inverse,
+	Ray::time_t minTime, Ray::time_t& closestTime, size_t& closestIndex) const {
+	for (size_t index = first; index < last; ++index) {
+		const float x0 = (m_minX[index] - origin.x) * inverse.x;
+		const float x1 = (m_maxX[index] - origin.x) * inverse.x;
+		const float y0 = (m_minY[index] - origin.y) * inverse.y;
+		const float y1 = (m_maxY[index] - origin.y) * inverse.y;
+		const float z0 = (m_minZ[index] - origin.z) * inverse.z;
+		const float z1 = (m_maxZ[index] - origin.z) * inverse.z;
+
+		const float enter = Max(Max(Max(Min(x0, x1), Min(y0, y1)), Min(z0, z1)), minTime);
+		const float exit = Min(Min(Max(x0, x1), Max(y0, y1)), Max(z0, z1));
+
+		if (enter <= exit && enter <= closestTime) {
+			Select(index, enter, closestTime, closestIndex);
+		}
+	}
+}
+
+size_t AABBBatch::Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const {
+	visible.resize(Size());
+	const auto& planes = frustum.Planes();
+	size_t count = 0;
+	size_t index = 0;
+
+	// Dla kazdej plaszczyzny wierzcholek najdalej w strone normalnej wybiera znak wspolczynnika,
+	// wspolny dla wszystkich pudelek, wiec wystarczy wybrac tablice min albo max
+	const auto selectX = [this](const glm::vec4& plane) { return plane.x >= 0.0f ? m_maxX.data() : m_minX.data(); };
+	const auto selectY = [this](const glm::vec4& plane) { return plane.y >= 0.0f ? m_maxY.data() : m_minY.data(); };
+	const auto selectZ = [this](const glm::vec4& plane) { return plane.z >= 0.0f ? m_maxZ.data() : m_minZ.data(); };
+
+#if defined(AABB_BATCH_AVX)
+	for (; index + 8 <= Size(); index += 8) {
+		__m256 outside = _mm256_setzero_ps();
+		for (const glm::vec4& plane : planes) {
+			const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_set1_ps(plane.x), _mm256_loadu_ps(selectX(plane) + index)),
+				_mm256_mul_ps(_mm256_set1_ps(plane.y), _mm256_loadu_ps(selectY(plane) + index))),
+				_mm256_mul_ps(_mm256_set1_ps(plane.z), _mm256_loadu_ps(selectZ(plane) + index))),
+				_mm256_set1_ps(plane.w));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		const int mask = _mm256_movemask_ps(outside);
+		for (size_t lane = 0; lane < 8; ++lane) {
+			visible[index + lane] = static_cast<uint8_t>(((mask >> lane) & 1) ^ 1);
+			count += visible[index + lane];
+		}
+	}
+#elif defined(AABB_BATCH_SSE)
+	for (; index + 4 <= Size(); index += 4) {
+		__m128 outside = _mm_setzero_ps();
+		for (const glm::vec4& plane : planes) {
+			const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(selectX(plane) + index)),
+				_mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(selectY(plane) + index))),
+				_mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(selectZ(plane) + index))),
+				_mm_set1_ps(plane.w));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+		const int mask = _mm_movemask_ps(outside);
+		for (size_t lane = 0; lane < 4; ++lane) {
+			visible[index + lane] = static_cast<uint8_t>(((mask >> lane) & 1) ^ 1);
+			count += visible[index + lane];
+		}
+	}
+#endif
+
+	for (; index < Size(); ++index) {
+		bool isOutside = false;
+		for (const glm::vec4& plane : planes) {
+			const float distance = plane.x * selectX(plane)[index] + plane.y * selectY(plane)[index]
+				+ plane.z * selectZ(plane)[index] + plane.w;
+			isOutside = isOutside || distance < 0.0f;
+		}
+		visible[index] = isOutside ? 0 : 1;
+		count += visible[index];
+	}
+	return count;
+}
+
+AABB::Axis AABBBatch::EntryAxis(size_t index, const glm::vec3& origin, const glm::vec3& inverse) const {
+	// Sciana, przez ktora promien wchodzi, lezy na osi z najpozniejszym wejsciem w slab
+	const float nearX = Min((m_minX[index] - origin.x) * inverse.x, (m_maxX[index] - origin.x) * inverse.x);
+	const float nearY = Min((m_minY[index] - origin.y) * inverse.y, (m_maxY[index] - origin.y) * inverse.y);
+	const float nearZ = Min((m_minZ[index] - origin.z) * inverse.z, (m_maxZ[index] - origin.z) * inverse.z);
+
+	AABB::Axis axis = AABB::Axis::x;
+	float enter = nearX;
+	if (nearY > enter) {
+		axis = AABB::Axis::y;
+		enter = nearY;
+	}
+	if (nearZ > enter) {
+		axis = AABB::Axis::z;
+	}
+	return axis;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "AABB.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Set of axis aligned boxes stored as structure of arrays, tested against one ray or one
+ * frustum at a time. Hit and Cull process 8 (AVX) or 4 (SSE) boxes per step, depending on
+ * the instruction set the project is compiled for. HitScalar does the same operations in the
+ * same order one box at a time, so both return bit-identical results.
+ */
+class AABBBatch {
+public:
+	struct HitRecord {
+		size_t m_index;
+		Ray::time_t m_time;
+		AABB::Axis m_axis;	// axis of the entered face
+	};
+
+	void Clear();
+	void Reserve(size_t count);
+	void Add(const glm::vec3& min, const glm::vec3& max);
+	void Add(const AABB& box) { Add(box.Min(), box.Max()); }
+
+	size_t Size() const { return m_minX.size(); }
+	bool Empty() const { return m_minX.empty(); }
+
+	/** Finds the box hit first in [minTime, maxTime]. Ties go to the box added first.
+	 * If the ray starts inside a box, the box is hit at minTime.
+	 */
+	Ray::HitType Hit(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const;
+	Ray::HitType HitScalar(const Ray& ray, Ray::time_t minTime, Ray::time_t maxTime, HitRecord& record) const;
+
+	/** Sets visible[i] to 1 if box i intersects the frustum (see Frustum::Intersects), 0 otherwise.
+	 * visible is resized to Size(). Returns the number of visible boxes.
+	 */
+	size_t Cull(const Frustum& frustum, std::vector<uint8_t>& visible) const;
+
+private:
+	void HitRange(size_t first, size_t last, const glm::vec3& origin, const glm::vec3& inverse,
+		Ray::time_t minTime, Ray::time_t& closestTime, size_t& closestIndex) const;
+	AABB::Axis EntryAxis(size_t index, const glm::vec3& origin, const glm::vec3& inverse) const;
+
+	std::vector<float> m_minX, m_minY, m_minZ;
+	std::vector<float> m_maxX, m_maxY, m_maxZ;
+};
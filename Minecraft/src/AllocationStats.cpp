@@ -0,0 +1,50 @@
+#include "AllocationStats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<uint64_t> s_allocations{ 0 };
+	std::atomic<uint64_t> s_deallocations{ 0 };
+	std::atomic<uint64_t> s_allocatedBytes{ 0 };
+}
+
+AllocationStats AllocationStats::Current() {
+	AllocationStats stats;
+	stats.m_allocations = s_allocations.load(std::memory_order_relaxed);
+	stats.m_deallocations = s_deallocations.load(std::memory_order_relaxed);
+	stats.m_allocatedBytes = s_allocatedBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+AllocationStats AllocationStats::operator-(const AllocationStats& rhs) const {
+	AllocationStats stats;
+	stats.m_allocations = m_allocations - rhs.m_allocations;
+	stats.m_deallocations = m_deallocations - rhs.m_deallocations;
+	stats.m_allocatedBytes = m_allocatedBytes - rhs.m_allocatedBytes;
+	return stats;
+}
+
+// Globalne operatory new/delete zliczajace alokacje; wersje tablicowe i nothrow
+// z biblioteki standardowej wolaja te ponizej
+void* operator new(std::size_t size) {
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	if (void* ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr) {
+		s_deallocations.fetch_add(1, std::memory_order_relaxed);
+		std::free(ptr);
+	}
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	operator delete(ptr);
+}
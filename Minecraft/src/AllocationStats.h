@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+/** Snapshot of global heap allocation counters.
+ * Counters are updated by the replaced global operator new/delete (see AllocationStats.cpp),
+ * so they cover every allocation of the program, including ones made by the standard library.
+ * Difference of two snapshots tells how much was allocated in between.
+ */
+struct AllocationStats {
+	uint64_t m_allocations{ 0 };
+	uint64_t m_deallocations{ 0 };
+	uint64_t m_allocatedBytes{ 0 };
+
+	static AllocationStats Current();
+
+	AllocationStats operator-(const AllocationStats& rhs) const;
+};
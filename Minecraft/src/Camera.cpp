@@ -50,6 +50,10 @@ Camera::Camera(const glm::vec3& position, const glm::vec3& front, float yaw, flo
      m_position -= m_up * dt;
      RecreateLootAt();
  }
+ void Camera::SetPosition(const glm::vec3& position) {
+     m_position = position;
+     RecreateLootAt();
+ }
  void Camera::Rotate(const sf::Vector2i& mouseDelta) {
      m_yaw += mouseDelta.x;
      m_pitch -= mouseDelta.y;
@@ -16,12 +16,14 @@ public:
 	void MoveRight(float dt);
 	void MoveUp(float dt);
 	void MoveDown(float dt);
+	void SetPosition(const glm::vec3& position);
 
 	const glm::mat4& GetProjection() const;
 	const glm::mat4& GetLookAt() const;
 
 	const glm::vec3& GetPosition() const { return m_position; }
 	const glm::vec3& GetFront() const { return m_front; }
+	const glm::vec3& GetRight() const { return m_right; }
 
 
 private:
@@ -1,18 +1,27 @@
 #pragma once
 #include "Cube.h"
-#include "ShaderProgram.h"
-#include "PerlinNoise.h"
+#include "TerrainGenerator.h"
 #include "CubePalette.h"
 #include "Ray.h"
 #include "AABB.h"
+#include "AABBBatch.h"
+#include "ChunkMesh.h"
+#include "ChunkMesher.h"
+#include "Frustum.h"
+#include "MeshBuffer.h"
+#include "SparseSet.h"
+#include "PaletteStorage.h"
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
 #include <array>
+#include <memory>
 #include <vector>
 #include <optional>
+#include <utility>
 
 
 
@@ -21,15 +30,46 @@
  * Order of dimensions is as follow: depth, width, heigh.
  * Each chunk has it's own 2D origin vector which represents it's world. In world coordinates
  * corresponds to first block
+ * The chunk is split into sections stacked along Y axis, each s_sectionHeight blocks tall.
+ * Section cube types are palette compressed, visibility data and mesh are kept per section.
+ * Sections holding only air keep no per-block data and are skipped by generation, visibility,
+ * meshing, ray casting and drawing, so tall chunks mostly pay for their terrain, not the sky.
+ * Inside a section depth is the fastest changing coordinate, then width, then height.
+ * Chunks can be linked with their horizontal neighbours (Back, Front, Left and Right faces),
+ * so block edits on chunk border also update cubes of the adjacent chunk and faces of border
+ * blocks covered by the adjacent chunk are not drawn.
  */
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
 class Chunk {
-    struct CubeData {
-        Cube::Type m_type{ Cube::Type::None };
-        bool m_isVisible{ true };
+public:
+    static constexpr size_t s_sectionHeight = 16;
+    static constexpr size_t s_sectionCount = Height / s_sectionHeight;
+    static_assert(Height % s_sectionHeight == 0, "Chunk height must be a multiple of the section height");
+
+private:
+    static constexpr size_t s_sectionVolume = static_cast<size_t>(Depth) * Width * s_sectionHeight;
+
+    using SectionTypes_t = PaletteStorage<Cube::Type, s_sectionVolume>;
+    using SectionFaces_t = std::array<uint8_t, s_sectionVolume>;   // bitmask of Cube::FaceMask()
+
+    struct SectionVisibility {
+        SectionFaces_t m_visibleFaces{};
+        SparseSet<s_sectionVolume> m_visibleBlocks;
     };
 
-    using FlattenData_t = std::array<CubeData, Depth* Width* Height>;
+    /** Visibility is allocated the first time the section holds a cube and is kept afterwards,
+     * so recycled chunks do not allocate it again.
+     */
+    struct Section {
+        bool IsEmpty() const { return m_types.IsUniform() && m_types.UniformValue() == Cube::Type::None; }
+
+        SectionTypes_t m_types;
+        std::unique_ptr<SectionVisibility> m_visibility;
+        ChunkMeshData m_meshData;
+        ChunkMeshData m_rebuiltMeshData;    // budowana przez RebuildMesh obok rysowanej
+        bool m_isMeshDirty{ false };
+        bool m_isRebuilding{ false };
+    };
 
 public:
     struct HitRecord {
@@ -37,112 +77,335 @@ public:
         glm::ivec3 m_neighbourIndex;
     };
 
-    Chunk(const glm::vec2& origin, CubePalette& palette);
+    /** Sections with a mesh tested against the frustum by Draw, those of them not drawn
+     * and the number of draws added to the mesh buffer.
+     */
+    struct DrawStats {
+        size_t m_testedSections{ 0 };
+        size_t m_culledSections{ 0 };
+        size_t m_draws{ 0 };
+    };
 
-    void Generate(const PerlinNoise& rng);
-    void Draw(ShaderProgram& shader) const;
+    explicit Chunk(const glm::vec2& origin);
+    ~Chunk();
+
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    /** Makes the chunk empty and moves it to a new origin, so it can be reused for another
+     * part of the world. Buffers (visible blocks, mesh data, GPU buffers) are kept.
+     */
+    void Reset(const glm::vec2& origin);
+
+    void Generate(const TerrainGenerator& generator);
+    /** Adds draws of sections with a mesh whose bounds intersect the frustum to buffer, one draw per
+     * run of neighbouring visible sections. The chunk mesh is uploaded to buffer when any of its
+     * sections becomes visible. The draws are issued by MeshBuffer::Draw.
+     */
+    void Draw(MeshBuffer& buffer, const CubePalette& palette, const Frustum& frustum, DrawStats& stats);
+
+    /** Builds greedy mesh of one section from its cube data, in section local coordinates.
+     * Does not touch GL state.
+     */
+    void BuildMesh(size_t section, ChunkMeshData& mesh) const;
+
+    /** Rebuilds CPU side of the meshes of sections whose cube data changed. Safe to call from
+     * a worker thread, the meshes are uploaded to the GPU on the next Draw.
+     */
+    void UpdateMesh();
+
+    /** Hands sections whose cube data changed over to RebuildMesh, so Draw does not mesh them;
+     * until EndMeshRebuild they are drawn with their previous meshes. Returns false if there is
+     * nothing to rebuild.
+     */
+    bool BeginMeshRebuild();
+    /** Builds meshes of the sections handed over by BeginMeshRebuild aside from the drawn ones.
+     * Safe to call from a worker thread while the chunk is drawn, as long as no block of the
+     * chunk or of its neighbours is modified.
+     */
+    void RebuildMesh();
+    /** Replaces drawn meshes with the rebuilt ones, they are uploaded on the next Draw. */
+    void EndMeshRebuild();
 
     Ray::HitType Hit(const Ray& ray, Ray::time_t min, Ray::time_t max,
         HitRecord& record) const;
 
-    bool RemoveBlock(uint8_t width, uint8_t height, uint8_t depth);
-    bool PlaceBlock(uint8_t width, uint8_t height, uint8_t depth, Cube::Type type);
+    /** Returns cube type at given local coordinates, None outside of the chunk. */
+    Cube::Type GetBlock(int width, int height, int depth) const;
+
+    bool RemoveBlock(uint8_t width, uint16_t height, uint8_t depth);
+    bool PlaceBlock(uint8_t width, uint16_t height, uint8_t depth, Cube::Type type);
+
+    /** Links this chunk with the chunk adjacent to given side, the link is set both ways.
+     * Only Back, Front, Left and Right sides are supported. Passing nullptr unlinks the side.
+     * Linking updates visibility of the border blocks of both chunks, so faces covered by the
+     * other chunk are hidden and the sections whose border changed are marked for meshing. Unlinking
+     * keeps visibility as it is, the faces would only show towards an unloaded chunk.
+     */
+    void SetNeighbour(Cube::Face side, Chunk* neighbour);
+
+    const AABB& GetAABB() const { return m_aabb; }
+
+    /** Memory used by cube types, including the palette storage itself. */
+    size_t TypesMemoryUsage() const;
+
+    /** Index of the block in the whole chunk, in the order used by Serialize and ApplyEdits. */
+    static uint32_t ColumnIndex(size_t width, size_t height, size_t depth) {
+        return static_cast<uint32_t>((height * Width + width) * Depth + depth);
+    }
+
+    /** Sets cube types of blocks given by ColumnIndex and rebuilds visibility once, e.g. to
+     * replay journaled edits over generated blocks. Entries out of range are skipped.
+     */
+    void ApplyEdits(const std::vector<std::pair<uint32_t, Cube::Type>>& edits);
+
+    /** Appends cube types to out, run length encoded: format version, chunk dimensions and
+     * (type, LEB128 run length) pairs in section order. Uniform sections are not unpacked.
+     */
+    void Serialize(std::vector<uint8_t>& out) const;
+
+    /** Replaces cube types with serialized ones and rebuilds visibility. Returns false and leaves
+     * the chunk unchanged if the data is damaged or was saved for other chunk dimensions.
+     */
+    bool Deserialize(const uint8_t* data, size_t size);
+
+    /** Rebuilds visible faces and visible blocks of every non empty section from cube types.
+     * Called by Generate, ApplyEdits and Deserialize.
+     */
+    void UpdateVisibility();
 
 private:
     size_t CoordsToIndex(size_t depth, size_t width, size_t height) const;
-    void UpdateVisibility();
+    Cube::Type TypeAt(size_t depth, size_t width, size_t height) const;
+    uint8_t VisibleFaces(size_t depth, size_t width, size_t height) const;
+    void UpdateSectionVisibility(size_t section);
     void UpdateBlockVisibility(size_t depth, size_t width, size_t height);
+    void UpdateCubeVisibility(size_t depth, size_t width, size_t height);
+    void UpdateBorderVisibility(Cube::Face side);
+
+    /** Tells whether the block of the neighbour at given side, in its own coordinates, is empty.
+     * Without a neighbour the face is treated as visible.
+     */
+    bool IsNeighbourEmpty(Cube::Face side, size_t depth, size_t width, size_t height) const;
+
+    static constexpr size_t SideIndex(Cube::Face side) { return static_cast<size_t>(side); }
 
-    CubePalette& m_palette;
-    FlattenData_t m_data;
+    std::array<Section, s_sectionCount> m_sections;
+    ChunkMesh m_mesh;
+    bool m_isUploadPending{ false };
     glm::vec2 m_origin;
     AABB m_aabb;
-    std::vector<size_t> m_visibleBlocks;
+    std::array<Chunk*, 4> m_neighbours{};
+
+    static constexpr uint8_t s_serializationVersion = 1;
 };
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline Chunk<Depth, Width, Height>::Chunk(const glm::vec2& origin, CubePalette& palette)
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline Chunk<Depth, Width, Height>::Chunk(const glm::vec2& origin)
     : m_origin(origin),
-    m_palette(palette),
     m_aabb(
         glm::vec3(origin.x, 0, origin.y),
         glm::vec3(origin.x + Width, Height, origin.y + Depth))
 {}
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline void Chunk<Depth, Width, Height>::Generate(const PerlinNoise& rng) {
-    float scale = 0.09f;
-
-    for (size_t z = 0; z < Depth; ++z) {
-        for (size_t x = 0; x < Width; ++x) {
-            float height = rng.At(glm::vec3((m_origin.x + x) * scale, 0.0f,
-                (m_origin.y + z) * scale)) *
-                Height;
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline Chunk<Depth, Width, Height>::~Chunk() {
+    for (size_t side = 0; side < m_neighbours.size(); ++side) {
+        SetNeighbour(static_cast<Cube::Face>(side), nullptr);
+    }
+}
 
-            for (size_t y = 0; y < Height; ++y) {
-                size_t index = CoordsToIndex(z, x, y);
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::Reset(const glm::vec2& origin) {
+    for (size_t side = 0; side < m_neighbours.size(); ++side) {
+        SetNeighbour(static_cast<Cube::Face>(side), nullptr);
+    }
 
-                if (y < height - 1) {
-                    m_data[index].m_type = Cube::Type::Stone;
-                }
-                else if (y == static_cast<int>(height) - 1) {
-                    m_data[index].m_type = Cube::Type::GrassDebug;
-                }
-                else {
-                    m_data[index].m_type = Cube::Type::None;
-                }
-            }
+    m_origin = origin;
+    m_aabb = AABB(
+        glm::vec3(origin.x, 0, origin.y),
+        glm::vec3(origin.x + Width, Height, origin.y + Depth));
+    for (Section& section : m_sections) {
+        section.m_types.Fill(Cube::Type::None);
+        if (section.m_visibility) {
+            section.m_visibility->m_visibleFaces.fill(0);
+            section.m_visibility->m_visibleBlocks.Clear();
+        }
+        section.m_meshData.Clear();
+        section.m_rebuiltMeshData.Clear();
+        section.m_isMeshDirty = true;
+        section.m_isRebuilding = false;
+    }
+    m_isUploadPending = false;
+}
 
-            if (height > 0 && height < Height) {
-                size_t topIndex = CoordsToIndex(z, x, static_cast<size_t>(height) - 1);
-                m_data[topIndex].m_type = Cube::Type::GrassDebug;
-            }
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::Generate(const TerrainGenerator& generator) {
+    // Generator wypelnia cala kolumne w ukladzie sekcji, wiec kazda sekcja to ciagly fragment bufora
+    static thread_local std::vector<Cube::Type> types;
+    types.resize(s_sectionVolume * s_sectionCount);
+    const int top = generator.Generate(
+        glm::ivec3(m_origin.x, 0, m_origin.y), glm::ivec3(Width, Height, Depth), types.data());
+
+    for (size_t section = 0; section < s_sectionCount; ++section) {
+        // Sekcje nad najwyzsza warstwa z blokami nie potrzebuja kompresji bufora
+        if (static_cast<int>(section * s_sectionHeight) >= top) {
+            m_sections[section].m_types.Fill(Cube::Type::None);
+            continue;
         }
+        m_sections[section].m_types.Assign(types.data() + section * s_sectionVolume);
     }
     UpdateVisibility();
 }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline void Chunk<Depth, Width, Height>::Draw(ShaderProgram& shader) const {
-    shader.Use();
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::Draw(MeshBuffer& buffer, const CubePalette& palette,
+    const Frustum& frustum, DrawStats& stats) {
+    UpdateMesh();
+
+    std::array<uint8_t, s_sectionCount> isSectionVisible{};
+    bool isAnyVisible = false;
+    for (size_t index = 0; index < s_sectionCount; ++index) {
+        // Pusta siatka nie wymaga testu
+        if (m_sections[index].m_meshData.m_vertices.empty()) {
+            continue;
+        }
+
+        ++stats.m_testedSections;
+        const glm::vec3 bottom(m_origin.x, index * s_sectionHeight, m_origin.y);
+        if (!frustum.Intersects(bottom, bottom + glm::vec3(Width, s_sectionHeight, Depth))) {
+            ++stats.m_culledSections;
+            continue;
+        }
+
+        isSectionVisible[index] = 1;
+        isAnyVisible = true;
+    }
+
+    if (!isAnyVisible) {
+        return;
+    }
+
+    if (m_isUploadPending) {
+        std::array<const ChunkMeshData*, s_sectionCount> meshes;
+        for (size_t index = 0; index < s_sectionCount; ++index) {
+            meshes[index] = &m_sections[index].m_meshData;
+        }
+        m_mesh.Upload(buffer, palette, meshes.data(), meshes.size(), static_cast<float>(s_sectionHeight));
+        m_isUploadPending = false;
+    }
+
+    stats.m_draws += m_mesh.Draw(glm::vec3(m_origin.x, 0.0f, m_origin.y), isSectionVisible.data());
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateMesh() {
+    for (size_t index = 0; index < s_sectionCount; ++index) {
+        Section& section = m_sections[index];
+        if (!section.m_isMeshDirty) {
+            continue;
+        }
 
-    for (size_t index : m_visibleBlocks) {
-        size_t z = index % Depth;
-        size_t x = (index / Depth) % Width;
-        size_t y = index / (Depth * Width);
+        BuildMesh(index, section.m_meshData);
+        section.m_isMeshDirty = false;
+        m_isUploadPending = true;
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool Chunk<Depth, Width, Height>::BeginMeshRebuild() {
+    bool isAnyRebuilt = false;
+    for (Section& section : m_sections) {
+        if (section.m_isMeshDirty) {
+            section.m_isMeshDirty = false;
+            section.m_isRebuilding = true;
+        }
+        isAnyRebuilt = isAnyRebuilt || section.m_isRebuilding;
+    }
+    return isAnyRebuilt;
+}
 
-        glm::mat4 model = glm::translate(
-            glm::mat4(1.0f), glm::vec3(m_origin.x + x, y, m_origin.y + z));
-        shader.SetMat4("model", model);
-        m_palette.LookUp(m_data[index].m_type).Draw();
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::RebuildMesh() {
+    for (size_t index = 0; index < s_sectionCount; ++index) {
+        if (m_sections[index].m_isRebuilding) {
+            BuildMesh(index, m_sections[index].m_rebuiltMeshData);
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::EndMeshRebuild() {
+    // Zamiana zamiast kopii - stara siatka zostaje buforem nastepnej przebudowy
+    for (Section& section : m_sections) {
+        if (section.m_isRebuilding) {
+            std::swap(section.m_meshData, section.m_rebuiltMeshData);
+            section.m_isRebuilding = false;
+            m_isUploadPending = true;
+        }
     }
 }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::BuildMesh(size_t section, ChunkMeshData& mesh) const {
+    static thread_local ChunkMesher mesher;
+
+    const Section& data = m_sections[section];
+    if (data.IsEmpty() || !data.m_visibility) {
+        mesh.Clear();
+        return;
+    }
+
+    mesher.Build<Depth, Width, s_sectionHeight>([this, &data](const glm::ivec3& cell) {
+        const size_t index = CoordsToIndex(cell.z, cell.x, cell.y);
+        return ChunkMesher::Cell{ data.m_types.Get(index), data.m_visibility->m_visibleFaces[index] };
+        }, mesh);
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
 inline Ray::HitType Chunk<Depth, Width, Height>::Hit(const Ray& ray, Ray::time_t min, Ray::time_t max, HitRecord& record) const {
     AABB::HitRecord chunkRecord;
     if (m_aabb.Hit(ray, min, max, chunkRecord) == Ray::HitType::Miss) {
         return Ray::HitType::Miss;
     }
 
-    glm::vec3 chunkOffset = glm::vec3(m_origin.x, 0, m_origin.y);
-
+    static thread_local AABBBatch batch;
     Ray::time_t closestTime = max;
     bool hitDetected = false;
 
-    for (size_t index : m_visibleBlocks) {
-        size_t z = index % Depth;
-        size_t x = (index / Depth) % Width;
-        size_t y = index / (Depth * Width);
+    for (size_t section = 0; section < s_sectionCount; ++section) {
+        const Section& data = m_sections[section];
+        if (data.IsEmpty() || !data.m_visibility) {
+            continue;
+        }
+
+        glm::vec3 sectionOffset = glm::vec3(m_origin.x, section * s_sectionHeight, m_origin.y);
+        AABB sectionAABB(sectionOffset, sectionOffset + glm::vec3(Width, s_sectionHeight, Depth));
+        AABB::HitRecord sectionRecord;
+        if (sectionAABB.Hit(ray, min, closestTime, sectionRecord) == Ray::HitType::Miss) {
+            continue;
+        }
+
+        // Widoczne bloki sekcji testujemy naraz, jednym przebiegiem AABBBatch
+        batch.Clear();
+        for (size_t index : data.m_visibility->m_visibleBlocks) {
+            size_t z = index % Depth;
+            size_t x = (index / Depth) % Width;
+            size_t y = index / (Depth * Width);
 
-        glm::vec3 cubeMin = chunkOffset + glm::vec3(x, y, z);
-        glm::vec3 cubeMax = cubeMin + glm::vec3(1.0f); // Cubes are 1x1x1
-        AABB cubeAABB(cubeMin, cubeMax);
+            glm::vec3 cubeMin = sectionOffset + glm::vec3(x, y, z);
+            batch.Add(cubeMin, cubeMin + glm::vec3(1.0f)); // Cubes are 1x1x1
+        }
+
+        AABBBatch::HitRecord cubeRecord;
+        if (batch.Hit(ray, min, closestTime, cubeRecord) == Ray::HitType::Hit) {
+            const size_t index = *(data.m_visibility->m_visibleBlocks.begin() + cubeRecord.m_index);
+            size_t z = index % Depth;
+            size_t x = (index / Depth) % Width;
+            size_t y = index / (Depth * Width);
 
-        AABB::HitRecord cubeRecord;
-        if (cubeAABB.Hit(ray, min, closestTime, cubeRecord) == Ray::HitType::Hit) {
             closestTime = cubeRecord.m_time;
-            record.m_cubeIndex = glm::ivec3(x, y, z);
+            record.m_cubeIndex = glm::ivec3(x, section * s_sectionHeight + y, z);
 
             glm::ivec3 neighborOffset = glm::ivec3(0);
             if (cubeRecord.m_axis == AABB::Axis::x) {
@@ -163,32 +426,178 @@ inline Ray::HitType Chunk<Depth, Width, Height>::Hit(const Ray& ray, Ray::time_t
     return hitDetected ? Ray::HitType::Hit : Ray::HitType::Miss;
 }
 
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline Cube::Type Chunk<Depth, Width, Height>::GetBlock(int width, int height, int depth) const {
+    if (depth < 0 || depth >= Depth || width < 0 || width >= Width || height < 0 || height >= Height) {
+        return Cube::Type::None;
+    }
+    return TypeAt(depth, width, height);
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool Chunk<Depth, Width, Height>::RemoveBlock(uint8_t width, uint16_t height, uint8_t depth) {
+    if (depth >= Depth || width >= Width || height >= Height) {
+        return false;
+    }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline bool Chunk<Depth, Width, Height>::RemoveBlock(uint8_t width, uint8_t height, uint8_t depth) {
-    size_t index = CoordsToIndex(depth, width, height);
-    if (m_data[index].m_type == Cube::Type::None) {
+    SectionTypes_t& types = m_sections[height / s_sectionHeight].m_types;
+    size_t index = CoordsToIndex(depth, width, height % s_sectionHeight);
+    if (types.Get(index) == Cube::Type::None) {
         return false; // Blok ju nie istnieje
     }
-    m_data[index].m_type = Cube::Type::None; // Ustaw typ na None
+    types.Set(index, Cube::Type::None); // Ustaw typ na None
     UpdateBlockVisibility(depth, width, height); // Zaktualizuj widoczno ssiadw
     return true; // Blok zosta usunity
 }
 
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
-inline bool Chunk<Depth, Width, Height>::PlaceBlock(uint8_t width, uint8_t height, uint8_t depth, Cube::Type type) {
-    size_t index = CoordsToIndex(depth, width, height);
-    if (m_data[index].m_type != Cube::Type::None) {
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool Chunk<Depth, Width, Height>::PlaceBlock(uint8_t width, uint16_t height, uint8_t depth, Cube::Type type) {
+    if (depth >= Depth || width >= Width || height >= Height) {
+        return false;
+    }
+
+    SectionTypes_t& types = m_sections[height / s_sectionHeight].m_types;
+    size_t index = CoordsToIndex(depth, width, height % s_sectionHeight);
+    if (types.Get(index) != Cube::Type::None) {
         return false;
     }
 
-    m_data[index].m_type = type;
+    types.Set(index, type);
     UpdateBlockVisibility(depth, width, height); // Zaktualizuj widoczno ssiadw
     return true;
 }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::SetNeighbour(Cube::Face side, Chunk* neighbour) {
+    // Przeciwna strona ma indeks rozniacy sie ostatnim bitem (Back <-> Front, Left <-> Right)
+    const size_t index = SideIndex(side);
+    const size_t opposite = index ^ 1;
+
+    if (m_neighbours[index] && m_neighbours[index]->m_neighbours[opposite] == this) {
+        m_neighbours[index]->m_neighbours[opposite] = nullptr;
+    }
+
+    m_neighbours[index] = neighbour;
+    if (neighbour) {
+        neighbour->m_neighbours[opposite] = this;
+        UpdateBorderVisibility(side);
+        neighbour->UpdateBorderVisibility(static_cast<Cube::Face>(opposite));
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline size_t Chunk<Depth, Width, Height>::TypesMemoryUsage() const {
+    size_t bytes = 0;
+    for (const Section& section : m_sections) {
+        bytes += sizeof(section.m_types) + section.m_types.MemoryUsage();
+    }
+    return bytes;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::Serialize(std::vector<uint8_t>& out) const {
+    out.push_back(s_serializationVersion);
+    out.push_back(Width);
+    out.push_back(Depth);
+    out.push_back(static_cast<uint8_t>(Height & 0xFF));
+    out.push_back(static_cast<uint8_t>(Height >> 8));
+
+    Cube::Type runType = Cube::Type::None;
+    size_t runLength = 0;
+    const auto appendRun = [&]() {
+        if (runLength == 0) {
+            return;
+        }
+        out.push_back(static_cast<uint8_t>(runType));
+        for (size_t length = runLength; ; length >>= 7) {
+            const uint8_t byte = static_cast<uint8_t>(length & 0x7F);
+            if (length < 0x80) {
+                out.push_back(byte);
+                break;
+            }
+            out.push_back(byte | 0x80);
+        }
+    };
+    const auto append = [&](Cube::Type type, size_t count) {
+        if (type != runType) {
+            appendRun();
+            runType = type;
+            runLength = 0;
+        }
+        runLength += count;
+    };
+
+    std::array<Cube::Type, s_sectionVolume> types;
+    for (const Section& section : m_sections) {
+        if (section.m_types.IsUniform()) {
+            append(section.m_types.UniformValue(), s_sectionVolume);
+            continue;
+        }
+        section.m_types.Unpack(types.data());
+        for (Cube::Type type : types) {
+            append(type, 1);
+        }
+    }
+    appendRun();
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool Chunk<Depth, Width, Height>::Deserialize(const uint8_t* data, size_t size) {
+    if (size < 5 || data[0] != s_serializationVersion || data[1] != Width || data[2] != Depth
+        || (data[3] | data[4] << 8) != Height) {
+        return false;
+    }
+
+    // Najpierw dekodujemy cala kolumne, zeby uszkodzone dane nie zmienily chunka
+    static thread_local std::vector<Cube::Type> types;
+    types.resize(s_sectionVolume * s_sectionCount);
+    size_t count = 0;
+    for (size_t offset = 5; offset < size;) {
+        const uint8_t type = data[offset++];
+        if (type >= Cube::s_typeCount) {
+            return false;
+        }
+
+        size_t length = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (offset == size || shift > 28) {
+                return false;
+            }
+            const uint8_t byte = data[offset++];
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        if (length > types.size() - count) {
+            return false;
+        }
+        std::fill_n(types.begin() + count, length, static_cast<Cube::Type>(type));
+        count += length;
+    }
+    if (count != types.size()) {
+        return false;
+    }
+
+    for (size_t section = 0; section < s_sectionCount; ++section) {
+        m_sections[section].m_types.Assign(types.data() + section * s_sectionVolume);
+    }
+    UpdateVisibility();
+    return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::ApplyEdits(const std::vector<std::pair<uint32_t, Cube::Type>>& edits) {
+    for (const auto& [block, type] : edits) {
+        if (block < s_sectionVolume * s_sectionCount && static_cast<size_t>(type) < Cube::s_typeCount) {
+            m_sections[block / s_sectionVolume].m_types.Set(block % s_sectionVolume, type);
+        }
+    }
+    UpdateVisibility();
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
 inline size_t Chunk<Depth, Width, Height>::CoordsToIndex(size_t depth,
     size_t width,
     size_t height) const {
@@ -196,44 +605,157 @@ inline size_t Chunk<Depth, Width, Height>::CoordsToIndex(size_t depth,
         width * static_cast<size_t>(Depth) + depth;
 }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline Cube::Type Chunk<Depth, Width, Height>::TypeAt(size_t depth, size_t width, size_t height) const {
+    return m_sections[height / s_sectionHeight].m_types.Get(
+        CoordsToIndex(depth, width, height % s_sectionHeight));
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline uint8_t Chunk<Depth, Width, Height>::VisibleFaces(size_t z, size_t x, size_t y) const {
+    if (TypeAt(z, x, y) == Cube::Type::None) {
+        return 0;
+    }
+
+    // Widoczne sa tylko sciany sasiadujace z pustym blokiem
+    uint8_t faces = 0;
+    // Na krawedzi chunka decyduje blok sasiedniego chunka
+    if (z == 0 ? IsNeighbourEmpty(Cube::Face::Back, Depth - 1, x, y) : TypeAt(z - 1, x, y) == Cube::Type::None)
+        faces |= Cube::FaceMask(Cube::Face::Back);
+    if (z == Depth - 1 ? IsNeighbourEmpty(Cube::Face::Front, 0, x, y) : TypeAt(z + 1, x, y) == Cube::Type::None)
+        faces |= Cube::FaceMask(Cube::Face::Front);
+    if (x == 0 ? IsNeighbourEmpty(Cube::Face::Left, z, Width - 1, y) : TypeAt(z, x - 1, y) == Cube::Type::None)
+        faces |= Cube::FaceMask(Cube::Face::Left);
+    if (x == Width - 1 ? IsNeighbourEmpty(Cube::Face::Right, z, 0, y) : TypeAt(z, x + 1, y) == Cube::Type::None)
+        faces |= Cube::FaceMask(Cube::Face::Right);
+    if (y == 0 || TypeAt(z, x, y - 1) == Cube::Type::None) faces |= Cube::FaceMask(Cube::Face::Bottom);
+    if (y == Height - 1 || TypeAt(z, x, y + 1) == Cube::Type::None) faces |= Cube::FaceMask(Cube::Face::Top);
+    return faces;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
 inline void Chunk<Depth, Width, Height>::UpdateVisibility() {
-    m_visibleBlocks.clear();
+    for (size_t section = 0; section < s_sectionCount; ++section) {
+        UpdateSectionVisibility(section);
+    }
+}
 
-    for (size_t z = 0; z < Depth; ++z) {
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateSectionVisibility(size_t section) {
+    Section& data = m_sections[section];
+    data.m_isMeshDirty = true;
+
+    // Pusta sekcja nie ma zadnych widocznych scian
+    if (data.IsEmpty()) {
+        if (data.m_visibility) {
+            data.m_visibility->m_visibleFaces.fill(0);
+            data.m_visibility->m_visibleBlocks.Clear();
+        }
+        return;
+    }
+
+    if (!data.m_visibility) {
+        data.m_visibility = std::make_unique<SectionVisibility>();
+    }
+    SectionVisibility& visibility = *data.m_visibility;
+    visibility.m_visibleBlocks.Clear();
+
+    const size_t bottom = section * s_sectionHeight;
+    size_t index = 0;
+    for (size_t y = 0; y < s_sectionHeight; ++y) {
         for (size_t x = 0; x < Width; ++x) {
-            for (size_t y = 0; y < Height; ++y) {
-                size_t index = CoordsToIndex(z, x, y);
-                if (m_data[index].m_type == Cube::Type::None) {
-                    m_data[index].m_isVisible = false;
-                    continue;
-                }
+            for (size_t z = 0; z < Depth; ++z, ++index) {
+                uint8_t faces = VisibleFaces(z, x, bottom + y);
 
-                bool isVisible = false;
-                if (z == 0 || m_data[CoordsToIndex(z - 1, x, y)].m_type == Cube::Type::None) isVisible = true;
-                if (z == Depth - 1 || m_data[CoordsToIndex(z + 1, x, y)].m_type == Cube::Type::None) isVisible = true;
-                if (x == 0 || m_data[CoordsToIndex(z, x - 1, y)].m_type == Cube::Type::None) isVisible = true;
-                if (x == Width - 1 || m_data[CoordsToIndex(z, x + 1, y)].m_type == Cube::Type::None) isVisible = true;
-                if (y == 0 || m_data[CoordsToIndex(z, x, y - 1)].m_type == Cube::Type::None) isVisible = true;
-                if (y == Height - 1 || m_data[CoordsToIndex(z, x, y + 1)].m_type == Cube::Type::None) isVisible = true;
-
-                m_data[index].m_isVisible = isVisible;
-                if (isVisible) {
-                    m_visibleBlocks.push_back(index);
+                visibility.m_visibleFaces[index] = faces;
+                if (faces) {
+                    visibility.m_visibleBlocks.Insert(index);
                 }
             }
         }
     }
 }
 
-template <uint8_t Depth, uint8_t Width, uint8_t Height>
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
 inline void Chunk<Depth, Width, Height>::UpdateBlockVisibility(size_t depth, size_t width, size_t height) {
-    auto updateNeighbor = [&](size_t d, size_t w, size_t h) {
-        if (d < Depth && w < Width && h < Height) {
-            UpdateVisibility(); 
+    // Zmiana jednego bloku wplywa tylko na niego i jego szesciu sasiadow
+    UpdateCubeVisibility(depth, width, height);
+
+    if (depth > 0) UpdateCubeVisibility(depth - 1, width, height);
+    else if (Chunk* back = m_neighbours[SideIndex(Cube::Face::Back)]) back->UpdateCubeVisibility(Depth - 1, width, height);
+
+    if (depth < Depth - 1) UpdateCubeVisibility(depth + 1, width, height);
+    else if (Chunk* front = m_neighbours[SideIndex(Cube::Face::Front)]) front->UpdateCubeVisibility(0, width, height);
+
+    if (width > 0) UpdateCubeVisibility(depth, width - 1, height);
+    else if (Chunk* left = m_neighbours[SideIndex(Cube::Face::Left)]) left->UpdateCubeVisibility(depth, Width - 1, height);
+
+    if (width < Width - 1) UpdateCubeVisibility(depth, width + 1, height);
+    else if (Chunk* right = m_neighbours[SideIndex(Cube::Face::Right)]) right->UpdateCubeVisibility(depth, 0, height);
+
+    if (height > 0) UpdateCubeVisibility(depth, width, height - 1);
+    if (height < Height - 1) UpdateCubeVisibility(depth, width, height + 1);
+
+    // Typ edytowanego bloku zmienil sie nawet jesli jego widocznosc nie
+    m_sections[height / s_sectionHeight].m_isMeshDirty = true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateCubeVisibility(size_t depth, size_t width, size_t height) {
+    Section& section = m_sections[height / s_sectionHeight];
+    uint8_t faces = VisibleFaces(depth, width, height);
+    if (!section.m_visibility) {
+        // Sekcja bez danych widocznosci nie ma widocznych scian
+        if (!faces) {
+            return;
         }
-        };
+        section.m_visibility = std::make_unique<SectionVisibility>();
+    }
+
+    size_t index = CoordsToIndex(depth, width, height % s_sectionHeight);
+    SectionVisibility& visibility = *section.m_visibility;
+    if (visibility.m_visibleFaces[index] == faces) {
+        return;
+    }
+
+    visibility.m_visibleFaces[index] = faces;
+    if (faces) {
+        visibility.m_visibleBlocks.Insert(index);
+    }
+    else {
+        visibility.m_visibleBlocks.Erase(index);
+    }
+    section.m_isMeshDirty = true;
+}
 
-    updateNeighbor(depth, width, height);
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void Chunk<Depth, Width, Height>::UpdateBorderVisibility(Cube::Face side) {
+    // Sciana chunka od strony sasiada: staly z (Back/Front) albo staly x (Left/Right)
+    const bool isAlongWidth = side == Cube::Face::Back || side == Cube::Face::Front;
+    const size_t fixed = side == Cube::Face::Front ? Depth - 1 : side == Cube::Face::Right ? Width - 1 : 0;
+    const size_t length = isAlongWidth ? Width : Depth;
+
+    for (size_t section = 0; section < s_sectionCount; ++section) {
+        // Pusta sekcja nie ma scian, ktore sasiad moglby zaslonic
+        if (m_sections[section].IsEmpty()) {
+            continue;
+        }
+        const size_t bottom = section * s_sectionHeight;
+        for (size_t y = bottom; y < bottom + s_sectionHeight; ++y) {
+            for (size_t i = 0; i < length; ++i) {
+                if (isAlongWidth) {
+                    UpdateCubeVisibility(fixed, i, y);
+                }
+                else {
+                    UpdateCubeVisibility(i, fixed, y);
+                }
+            }
+        }
+    }
 }
 
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool Chunk<Depth, Width, Height>::IsNeighbourEmpty(Cube::Face side, size_t depth, size_t width, size_t height) const {
+    const Chunk* neighbour = m_neighbours[SideIndex(side)];
+    return !neighbour || neighbour->TypeAt(depth, width, height) == Cube::Type::None;
+}
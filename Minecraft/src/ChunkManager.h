@@ -0,0 +1,682 @@
+#pragma once
+#include "AABBBatch.h"
+#include "Chunk.h"
+#include "CubePalette.h"
+#include "Frustum.h"
+#include "JobQueue.h"
+#include "MeshBuffer.h"
+#include "TerrainGenerator.h"
+#include "WorldStorage.h"
+#include "Ray.h"
+#include "ShaderProgram.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/** Keeps chunks within render distance of the player loaded.
+ * Work is done only when the player enters another chunk: chunks which left the
+ * (2 * renderDistance + 1)^2 window are unloaded and only the newly entered ones are
+ * generated, in the background through JobQueue.
+ * Chunks are stored in a fixed toroidal grid of the window size: chunk (x, z) lives in slot
+ * (x mod size, z mod size), so a chunk entering the window takes the slot of the chunk which
+ * has just left it on the opposite side. Lookups and neighbour queries are index arithmetic.
+ * Chunk objects in slots are recycled with Chunk::Reset, keeping all their buffers, so once
+ * every slot has been used, streaming chunks in and out does not allocate.
+ * Chunk coordinates are in chunks, X is world X and Y is world Z.
+ * Meshes of all chunks live in one MeshBuffer, so streaming chunks does not create GL buffers
+ * and all visible chunks are drawn with a single multi-draw where supported.
+ * A loaded chunk hides border faces of its neighbours and they hide its own. Sections changed
+ * by this are meshed again by a job in JobQueue while the chunks are drawn with their previous
+ * meshes, so the main thread only uploads meshes. A chunk with a running mesh job is not linked
+ * with new neighbours until the job finishes, edits wait for it.
+ * Blocks can be picked and edited in world coordinates, across chunk borders. With a
+ * WorldStorage every edit is journaled and replayed when the chunk is loaded again; chunks
+ * with many edits are saved whole and loaded instead of being generated.
+ */
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+class ChunkManager {
+public:
+    using Chunk_t = Chunk<Depth, Width, Height>;
+
+    /** Without storage every chunk is generated and edits are lost when the chunk is unloaded. */
+    ChunkManager(const TerrainGenerator& generator, JobQueue& jobQueue, int renderDistance,
+        WorldStorage* storage = nullptr);
+    ~ChunkManager();
+
+    ChunkManager(const ChunkManager&) = delete;
+    ChunkManager& operator=(const ChunkManager&) = delete;
+
+    void Update(const glm::vec3& playerPosition);
+
+    /** Draws loaded chunks intersecting the frustum. Bounds of all loaded chunks are tested in one
+     * batched pass, sections of the remaining chunks are then tested one by one.
+     */
+    void Draw(ShaderProgram& shader, const CubePalette& palette, const Frustum& frustum);
+
+    /** Calls func(const glm::ivec2& chunkPos, Chunk_t& chunk) for every loaded chunk. */
+    template <typename Func>
+    void ForEach(Func&& func);
+
+    struct Stats {
+        size_t m_createdChunks{ 0 };    // chunki skonstruowane w pustym slocie
+        size_t m_recycledChunks{ 0 };   // chunki uzyte ponownie przez Reset
+        size_t m_cancelledJobs{ 0 };
+        size_t m_snapshots{ 0 };        // chunki zapisane w calosci po wielu edycjach
+        size_t m_meshJobs{ 0 };         // przebudowy siatek po polaczeniu z sasiadem
+    };
+
+    /** Frustum culling, draw and mesh buffer counters of the last Draw. */
+    struct FrameStats {
+        size_t m_testedChunks{ 0 };
+        size_t m_culledChunks{ 0 };
+        size_t m_testedSections{ 0 };   // sekcje z siatka w chunkach, ktore przeszly test
+        size_t m_culledSections{ 0 };
+        size_t m_draws{ 0 };            // komendy rysowania, przy multi-draw w jednym wywolaniu
+        size_t m_drawCalls{ 0 };
+        MeshBuffer::Stats m_meshBuffer;
+    };
+
+    struct RaycastHit {
+        glm::ivec3 m_block;     // world coordinates of the hit block
+        glm::ivec3 m_normal;    // normal of the entered face, zero if the ray starts inside the block
+        Ray::time_t m_time;
+    };
+
+    /** Walks the voxel grid along the ray (Amanatides & Woo) and stops at the first solid block
+     * of a loaded chunk. Cost is proportional to the number of crossed cells, not to the number
+     * of loaded chunks or visible blocks.
+     */
+    bool Raycast(const Ray& ray, Ray::time_t maxTime, RaycastHit& hit);
+
+    /** Tells whether the block blocks movement. Blocks of chunks which are not loaded yet and
+     * blocks below the world count as solid, so bodies do not fall out of the world.
+     */
+    bool IsSolid(const glm::ivec3& block);
+
+    bool RemoveBlock(const glm::ivec3& block);
+    bool PlaceBlock(const glm::ivec3& block, Cube::Type type);
+
+    Chunk_t* Find(const glm::ivec2& chunkPos);
+
+    /** Tells whether the chunk containing position and its four neighbours are generated. */
+    bool IsLoadedAround(const glm::vec3& position);
+    size_t Size() const { return m_loadedCount; }
+    size_t Capacity() const { return m_slots.size(); }
+    const Stats& GetStats() const { return m_stats; }
+    const FrameStats& GetFrameStats() const { return m_frameStats; }
+
+private:
+    // Poczatkowy rozmiar bufora siatek na chunk, MeshBuffer rosnie, gdy to za malo
+    static constexpr size_t s_meshVerticesPerChunk = 4096;
+
+    enum class SlotState {
+        Empty,      // brak chunka dla m_position, czeka na kolejke
+        Generating, // zadanie w JobQueue lub w trakcie wykonywania
+        Stale,      // m_position wyszla z okna, ale watek roboczy jeszcze pisze do chunka
+        Ready
+    };
+
+    struct Slot {
+        std::optional<Chunk_t> m_chunk;
+        glm::ivec2 m_position{ 0 };
+        SlotState m_state{ SlotState::Empty };
+        std::atomic<bool> m_isCancelled{ false };
+        std::atomic<bool> m_isDone{ false };        // konczy tez zadanie przebudowy siatki
+        bool m_needsMeshJob{ false };   // Ready, sekcje przekazane do RebuildMesh, zadanie jeszcze nie w kolejce
+        bool m_isMeshing{ false };      // Ready, zadanie przebudowy siatki w kolejce lub w trakcie
+    };
+
+    glm::ivec2 ChunkAt(const glm::vec3& position) const;
+    glm::ivec2 ChunkOfBlock(const glm::ivec3& block) const;
+    glm::ivec3 LocalBlock(const glm::ivec3& block, const glm::ivec2& chunkPos) const;
+    bool IsInWindow(const glm::ivec2& chunkPos, const glm::ivec2& center) const;
+    size_t SlotIndex(const glm::ivec2& chunkPos) const;
+
+    void Load(const glm::ivec2& chunkPos);
+    void Unload(Slot& slot);
+    void SubmitWaiting();
+    void CollectReady();
+    void Activate(Slot& slot);
+    void SubmitMeshJobs();
+
+    /** Takes back a mesh job which has not started yet, SubmitMeshJobs pushes it again. Returns
+     * false if the job is running, blocks of the chunk and its neighbours must not change until then.
+     */
+    bool RecallMeshJob(Slot& slot);
+    /** Recalls or waits for mesh jobs of the chunk and its neighbours before a block edit. */
+    void StopMeshJobsAround(const glm::ivec2& chunkPos);
+
+    /** Journals an edit of a loaded chunk and saves the chunk whole once it has enough edits. */
+    void LogEdit(const glm::ivec2& chunkPos, Chunk_t& chunk, const glm::ivec3& local, Cube::Type type);
+
+    const TerrainGenerator& m_generator;
+    WorldStorage* m_storage;
+    JobQueue& m_jobQueue;
+    int m_renderDistance;
+    int m_size;
+    MeshBuffer m_meshBuffer;            // przed m_slots - siatki chunkow zwalniaja w nim miejsce przy usuwaniu
+
+    std::optional<glm::ivec2> m_center;
+    std::vector<Slot> m_slots;
+    size_t m_loadedCount{ 0 };
+    Stats m_stats;
+    std::vector<glm::ivec2> m_waiting;  // w zasiegu, ale jeszcze nie w kolejce (kolejka byla pelna)
+
+    // Bufory testu widocznosci, uzywane ponownie w kazdej klatce
+    AABBBatch m_cullBoxes;
+    std::vector<Chunk_t*> m_cullChunks;
+    std::vector<uint8_t> m_cullVisible;
+    FrameStats m_frameStats;
+};
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline ChunkManager<Depth, Width, Height>::ChunkManager(const TerrainGenerator& generator,
+    JobQueue& jobQueue, int renderDistance, WorldStorage* storage)
+    : m_generator(generator),
+    m_storage(storage),
+    m_jobQueue(jobQueue),
+    m_renderDistance(renderDistance),
+    m_size(2 * renderDistance + 1),
+    m_meshBuffer(static_cast<size_t>(m_size) * m_size * s_meshVerticesPerChunk,
+        static_cast<size_t>(m_size) * m_size * ((Chunk_t::s_sectionCount + 1) / 2)),
+    m_slots(static_cast<size_t>(m_size) * m_size)
+{
+    m_waiting.reserve(m_slots.size());
+    m_cullBoxes.Reserve(m_slots.size());
+    m_cullChunks.reserve(m_slots.size());
+    m_cullVisible.reserve(m_slots.size());
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline ChunkManager<Depth, Width, Height>::~ChunkManager() {
+    // Zadania, ktore juz ruszyly, pisza do slotow - musimy poczekac az sie skoncza
+    for (Slot& slot : m_slots) {
+        if (slot.m_state == SlotState::Generating || slot.m_state == SlotState::Stale || slot.m_isMeshing) {
+            slot.m_isCancelled.store(true, std::memory_order_relaxed);
+            if (!m_jobQueue.Cancel(slot.m_position)) {
+                while (!slot.m_isDone.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::Update(const glm::vec3& playerPosition) {
+    const glm::ivec2 center = ChunkAt(playerPosition);
+
+    if (m_center != center) {
+        m_jobQueue.SetFocus(center);
+
+        // Ladujemy tylko chunki, ktore weszly do okna; kazdy zajmuje slot chunka, ktory z niego wyszedl
+        for (int dx = -m_renderDistance; dx <= m_renderDistance; ++dx) {
+            for (int dz = -m_renderDistance; dz <= m_renderDistance; ++dz) {
+                const glm::ivec2 chunkPos = center + glm::ivec2(dx, dz);
+                if (!m_center || !IsInWindow(chunkPos, *m_center)) {
+                    Load(chunkPos);
+                }
+            }
+        }
+
+        m_center = center;
+
+        // Najblizsze chunki jako pierwsze trafiaja do kolejki
+        m_waiting.erase(std::remove_if(m_waiting.begin(), m_waiting.end(), [this](const glm::ivec2& chunkPos) {
+            return m_slots[SlotIndex(chunkPos)].m_position != chunkPos;
+            }), m_waiting.end());
+        std::sort(m_waiting.begin(), m_waiting.end(), [&center](const glm::ivec2& lhs, const glm::ivec2& rhs) {
+            const glm::ivec2 l = lhs - center;
+            const glm::ivec2 r = rhs - center;
+            return l.x * l.x + l.y * l.y > r.x * r.x + r.y * r.y;
+            });
+    }
+
+    // Przebudowy siatek przed nowymi chunkami - sa krotkie, a bez nich sasiedzi nie moga sie laczyc
+    CollectReady();
+    SubmitMeshJobs();
+    SubmitWaiting();
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::Draw(ShaderProgram& shader, const CubePalette& palette,
+    const Frustum& frustum) {
+    m_cullBoxes.Clear();
+    m_cullChunks.clear();
+    for (Slot& slot : m_slots) {
+        if (slot.m_state == SlotState::Ready) {
+            m_cullBoxes.Add(slot.m_chunk->GetAABB());
+            m_cullChunks.push_back(&*slot.m_chunk);
+        }
+    }
+
+    const size_t visibleCount = m_cullBoxes.Cull(frustum, m_cullVisible);
+    m_frameStats = FrameStats();
+    m_frameStats.m_testedChunks = m_cullChunks.size();
+    m_frameStats.m_culledChunks = m_cullChunks.size() - visibleCount;
+
+    // Chunk rysuje najwyzej co druga sekcje osobno, stad limit komend w konstruktorze
+    m_meshBuffer.BeginFrame();
+    typename Chunk_t::DrawStats drawStats;
+    for (size_t i = 0; i < m_cullChunks.size(); ++i) {
+        if (m_cullVisible[i]) {
+            m_cullChunks[i]->Draw(m_meshBuffer, palette, frustum, drawStats);
+        }
+    }
+    shader.Use();
+    m_frameStats.m_drawCalls = m_meshBuffer.Draw(palette.Texture());
+    m_frameStats.m_testedSections = drawStats.m_testedSections;
+    m_frameStats.m_culledSections = drawStats.m_culledSections;
+    m_frameStats.m_draws = drawStats.m_draws;
+    m_frameStats.m_meshBuffer = m_meshBuffer.GetStats();
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+template <typename Func>
+inline void ChunkManager<Depth, Width, Height>::ForEach(Func&& func) {
+    for (Slot& slot : m_slots) {
+        if (slot.m_state == SlotState::Ready) {
+            func(slot.m_position, *slot.m_chunk);
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline typename ChunkManager<Depth, Width, Height>::Chunk_t* ChunkManager<Depth, Width, Height>::Find(const glm::ivec2& chunkPos) {
+    Slot& slot = m_slots[SlotIndex(chunkPos)];
+    if (slot.m_state != SlotState::Ready || slot.m_position != chunkPos) {
+        return nullptr;
+    }
+    return &*slot.m_chunk;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::Raycast(const Ray& ray, Ray::time_t maxTime, RaycastHit& hit) {
+    const glm::vec3 origin = ray.Origin();
+    const glm::vec3 direction = ray.Direction();
+    const Ray::time_t infinity = std::numeric_limits<Ray::time_t>::infinity();
+
+    glm::ivec3 cell(glm::floor(origin));
+    glm::ivec3 step(0);
+    glm::vec3 nextTime(infinity);   // czas przeciecia najblizszej granicy komorki na kazdej osi
+    glm::vec3 deltaTime(infinity);  // czas przejscia przez cala komorke na kazdej osi
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] > 0.0f) {
+            step[axis] = 1;
+            deltaTime[axis] = 1.0f / direction[axis];
+            nextTime[axis] = (cell[axis] + 1 - origin[axis]) * deltaTime[axis];
+        }
+        else if (direction[axis] < 0.0f) {
+            step[axis] = -1;
+            deltaTime[axis] = -1.0f / direction[axis];
+            nextTime[axis] = (origin[axis] - cell[axis]) * deltaTime[axis];
+        }
+    }
+
+    glm::ivec3 normal(0);
+    Ray::time_t time = 0.0f;
+    glm::ivec2 chunkPos = ChunkOfBlock(cell);
+    const Chunk_t* chunk = Find(chunkPos);
+
+    for (;;) {
+        const glm::ivec3 local = LocalBlock(cell, chunkPos);
+        if (chunk && chunk->GetBlock(local.x, local.y, local.z) != Cube::Type::None) {
+            hit.m_block = cell;
+            hit.m_normal = normal;
+            hit.m_time = time;
+            return true;
+        }
+
+        // Przechodzimy do sasiedniej komorki przez najblizsza granice
+        int axis = 0;
+        if (nextTime.y < nextTime[axis]) axis = 1;
+        if (nextTime.z < nextTime[axis]) axis = 2;
+
+        time = nextTime[axis];
+        if (time > maxTime) {
+            return false;
+        }
+
+        cell[axis] += step[axis];
+        nextTime[axis] += deltaTime[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+
+        if (axis != 1) {
+            const glm::ivec2 nextChunkPos = ChunkOfBlock(cell);
+            if (nextChunkPos != chunkPos) {
+                chunkPos = nextChunkPos;
+                chunk = Find(chunkPos);
+            }
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::IsSolid(const glm::ivec3& block) {
+    if (block.y < 0) {
+        return true;
+    }
+    if (block.y >= Height) {
+        return false;
+    }
+
+    const glm::ivec2 chunkPos = ChunkOfBlock(block);
+    const Chunk_t* chunk = Find(chunkPos);
+    if (!chunk) {
+        return true;
+    }
+
+    const glm::ivec3 local = LocalBlock(block, chunkPos);
+    return chunk->GetBlock(local.x, local.y, local.z) != Cube::Type::None;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::RemoveBlock(const glm::ivec3& block) {
+    const glm::ivec2 chunkPos = ChunkOfBlock(block);
+    Chunk_t* chunk = Find(chunkPos);
+    if (!chunk || block.y < 0 || block.y >= Height) {
+        return false;
+    }
+
+    StopMeshJobsAround(chunkPos);
+    const glm::ivec3 local = LocalBlock(block, chunkPos);
+    if (!chunk->RemoveBlock(local.x, local.y, local.z)) {
+        return false;
+    }
+    LogEdit(chunkPos, *chunk, local, Cube::Type::None);
+    return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::PlaceBlock(const glm::ivec3& block, Cube::Type type) {
+    const glm::ivec2 chunkPos = ChunkOfBlock(block);
+    Chunk_t* chunk = Find(chunkPos);
+    if (!chunk || block.y < 0 || block.y >= Height) {
+        return false;
+    }
+
+    StopMeshJobsAround(chunkPos);
+    const glm::ivec3 local = LocalBlock(block, chunkPos);
+    if (!chunk->PlaceBlock(local.x, local.y, local.z, type)) {
+        return false;
+    }
+    LogEdit(chunkPos, *chunk, local, type);
+    return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::IsLoadedAround(const glm::vec3& position) {
+    const glm::ivec2 center = ChunkAt(position);
+    return Find(center) && Find(center + glm::ivec2(1, 0)) && Find(center - glm::ivec2(1, 0))
+        && Find(center + glm::ivec2(0, 1)) && Find(center - glm::ivec2(0, 1));
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline glm::ivec2 ChunkManager<Depth, Width, Height>::ChunkAt(const glm::vec3& position) const {
+    return glm::ivec2(static_cast<int>(std::floor(position.x / Width)),
+        static_cast<int>(std::floor(position.z / Depth)));
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline glm::ivec2 ChunkManager<Depth, Width, Height>::ChunkOfBlock(const glm::ivec3& block) const {
+    // Dzielenie zaokraglajace w dol, rowniez dla ujemnych wspolrzednych
+    const int x = block.x >= 0 ? block.x / Width : (block.x + 1) / Width - 1;
+    const int z = block.z >= 0 ? block.z / Depth : (block.z + 1) / Depth - 1;
+    return glm::ivec2(x, z);
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline glm::ivec3 ChunkManager<Depth, Width, Height>::LocalBlock(const glm::ivec3& block, const glm::ivec2& chunkPos) const {
+    return glm::ivec3(block.x - chunkPos.x * Width, block.y, block.z - chunkPos.y * Depth);
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::IsInWindow(const glm::ivec2& chunkPos, const glm::ivec2& center) const {
+    return std::abs(chunkPos.x - center.x) <= m_renderDistance
+        && std::abs(chunkPos.y - center.y) <= m_renderDistance;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline size_t ChunkManager<Depth, Width, Height>::SlotIndex(const glm::ivec2& chunkPos) const {
+    const int x = ((chunkPos.x % m_size) + m_size) % m_size;
+    const int z = ((chunkPos.y % m_size) + m_size) % m_size;
+    return static_cast<size_t>(z) * m_size + x;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::Load(const glm::ivec2& chunkPos) {
+    Slot& slot = m_slots[SlotIndex(chunkPos)];
+    if (m_center) {
+        Unload(slot);
+    }
+
+    slot.m_position = chunkPos;
+    m_waiting.push_back(chunkPos);
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::Unload(Slot& slot) {
+    switch (slot.m_state) {
+    case SlotState::Ready:
+        for (size_t side = 0; side < 4; ++side) {
+            slot.m_chunk->SetNeighbour(static_cast<Cube::Face>(side), nullptr);
+        }
+        // Budowana siatka jest juz niepotrzebna, ale watek moze jeszcze czytac chunk
+        slot.m_state = slot.m_isMeshing && !slot.m_isDone.load(std::memory_order_acquire)
+            && !m_jobQueue.Cancel(slot.m_position) ? SlotState::Stale : SlotState::Empty;
+        slot.m_needsMeshJob = false;
+        slot.m_isMeshing = false;
+        --m_loadedCount;
+        break;
+    case SlotState::Generating:
+        // Zadanie jeszcze nie ruszylo - slot od razu wolny, inaczej czekamy az watek skonczy
+        slot.m_state = m_jobQueue.Cancel(slot.m_position) ? SlotState::Empty : SlotState::Stale;
+        slot.m_isCancelled.store(true, std::memory_order_relaxed);
+        ++m_stats.m_cancelledJobs;
+        break;
+    default:
+        break;
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::SubmitWaiting() {
+    // m_waiting jest posortowane od najdalszego, wiec zdejmujemy z konca
+    for (size_t i = m_waiting.size(); i-- > 0;) {
+        const glm::ivec2 chunkPos = m_waiting[i];
+        Slot& slot = m_slots[SlotIndex(chunkPos)];
+        if (slot.m_state == SlotState::Stale) {
+            continue;
+        }
+
+        const glm::vec2 origin(chunkPos.x * Width, chunkPos.y * Depth);
+        if (slot.m_chunk) {
+            slot.m_chunk->Reset(origin);
+            ++m_stats.m_recycledChunks;
+        }
+        else {
+            slot.m_chunk.emplace(origin);
+            ++m_stats.m_createdChunks;
+        }
+        slot.m_isCancelled.store(false, std::memory_order_relaxed);
+        slot.m_isDone.store(false, std::memory_order_relaxed);
+
+        Slot* target = &slot;
+        const TerrainGenerator& generator = m_generator;
+        WorldStorage* storage = m_storage;
+        const bool isQueued = m_jobQueue.Push(chunkPos, [target, chunkPos, &generator, storage]() {
+            if (!target->m_isCancelled.load(std::memory_order_relaxed)) {
+                // Zapisane sa tylko chunki rozne od wyniku generatora
+                Chunk_t& chunk = *target->m_chunk;
+                const bool isLoaded = storage && storage->Load(chunkPos,
+                    [&chunk](const uint8_t* data, size_t size) { return chunk.Deserialize(data, size); });
+                if (!isLoaded) {
+                    chunk.Generate(generator);
+                }
+
+                // Edycje nowsze niz migawka (albo wszystkie, gdy chunk jest generowany) sa w dzienniku
+                if (storage) {
+                    static thread_local std::vector<std::pair<uint32_t, Cube::Type>> edits;
+                    edits.clear();
+                    storage->ReplayEdits(chunkPos, [](uint32_t block, uint8_t type) {
+                        edits.emplace_back(block, static_cast<Cube::Type>(type));
+                        });
+                    if (!edits.empty()) {
+                        chunk.ApplyEdits(edits);
+                    }
+                }
+                chunk.UpdateMesh();
+            }
+            target->m_isDone.store(true, std::memory_order_release);
+            });
+        // Kolejka pelna - sprobujemy ponownie w nastepnej klatce
+        if (!isQueued) {
+            return;
+        }
+
+        slot.m_state = SlotState::Generating;
+        m_waiting.erase(m_waiting.begin() + i);
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::CollectReady() {
+    for (Slot& slot : m_slots) {
+        if ((slot.m_state != SlotState::Generating && slot.m_state != SlotState::Stale && !slot.m_isMeshing)
+            || !slot.m_isDone.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        if (slot.m_isMeshing) {
+            slot.m_chunk->EndMeshRebuild();
+            slot.m_isMeshing = false;
+        }
+        else if (slot.m_state == SlotState::Stale) {
+            slot.m_state = SlotState::Empty;
+        }
+        else {
+            // Polaczenie zmienia widocznosc sasiadow, wiec nie moga byc w trakcie przebudowy siatki
+            const glm::ivec2 offsets[] = { glm::ivec2(0, -1), glm::ivec2(0, 1), glm::ivec2(-1, 0), glm::ivec2(1, 0) };
+            bool isAnyMeshing = false;
+            for (const glm::ivec2& offset : offsets) {
+                Slot& neighbour = m_slots[SlotIndex(slot.m_position + offset)];
+                if (Find(slot.m_position + offset) && !RecallMeshJob(neighbour)) {
+                    isAnyMeshing = true;
+                }
+            }
+            if (!isAnyMeshing) {
+                Activate(slot);
+            }
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::Activate(Slot& slot) {
+    // Laczymy chunk z sasiadami, zeby edycja bloku na krawedzi aktualizowala oba chunki.
+    // Polaczenie chowa zasloniete sciany na granicy, zmienione sekcje obu chunkow przebudowuje watek roboczy
+    const std::pair<Cube::Face, glm::ivec2> sides[] = {
+        { Cube::Face::Back, glm::ivec2(0, -1) },
+        { Cube::Face::Front, glm::ivec2(0, 1) },
+        { Cube::Face::Left, glm::ivec2(-1, 0) },
+        { Cube::Face::Right, glm::ivec2(1, 0) },
+    };
+    for (const auto& [side, offset] : sides) {
+        if (Chunk_t* neighbour = Find(slot.m_position + offset)) {
+            slot.m_chunk->SetNeighbour(side, neighbour);
+            Slot& neighbourSlot = m_slots[SlotIndex(slot.m_position + offset)];
+            neighbourSlot.m_needsMeshJob = neighbour->BeginMeshRebuild() || neighbourSlot.m_needsMeshJob;
+        }
+    }
+
+    slot.m_state = SlotState::Ready;
+    slot.m_needsMeshJob = slot.m_chunk->BeginMeshRebuild();
+    ++m_loadedCount;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::SubmitMeshJobs() {
+    for (Slot& slot : m_slots) {
+        if (!slot.m_needsMeshJob) {
+            continue;
+        }
+
+        slot.m_isDone.store(false, std::memory_order_relaxed);
+        Slot* target = &slot;
+        const bool isQueued = m_jobQueue.Push(slot.m_position, [target]() {
+            target->m_chunk->RebuildMesh();
+            target->m_isDone.store(true, std::memory_order_release);
+            });
+        // Kolejka pelna - sekcje sa rysowane ze starymi siatkami do nastepnej proby
+        if (!isQueued) {
+            return;
+        }
+
+        slot.m_needsMeshJob = false;
+        slot.m_isMeshing = true;
+        ++m_stats.m_meshJobs;
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline bool ChunkManager<Depth, Width, Height>::RecallMeshJob(Slot& slot) {
+    if (!slot.m_isMeshing) {
+        return true;
+    }
+
+    if (slot.m_isDone.load(std::memory_order_acquire)) {
+        slot.m_chunk->EndMeshRebuild();
+    }
+    else if (m_jobQueue.Cancel(slot.m_position)) {
+        slot.m_needsMeshJob = true;
+    }
+    else {
+        return false;
+    }
+    slot.m_isMeshing = false;
+    return true;
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::StopMeshJobsAround(const glm::ivec2& chunkPos) {
+    // Edycja na krawedzi zmienia tez widocznosc bloku sasiada
+    const glm::ivec2 offsets[] = { glm::ivec2(0, 0), glm::ivec2(0, -1), glm::ivec2(0, 1), glm::ivec2(-1, 0), glm::ivec2(1, 0) };
+    for (const glm::ivec2& offset : offsets) {
+        if (!Find(chunkPos + offset)) {
+            continue;
+        }
+        while (!RecallMeshJob(m_slots[SlotIndex(chunkPos + offset)])) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <uint8_t Depth, uint8_t Width, uint16_t Height>
+inline void ChunkManager<Depth, Width, Height>::LogEdit(const glm::ivec2& chunkPos, Chunk_t& chunk,
+    const glm::ivec3& local, Cube::Type type) {
+    if (!m_storage) {
+        return;
+    }
+
+    const uint64_t sequence = m_storage->LogEdit(chunkPos, Chunk_t::ColumnIndex(local.x, local.y, local.z),
+        static_cast<uint8_t>(type));
+    if (!m_storage->NeedsSnapshot(chunkPos)) {
+        return;
+    }
+
+    // Serializacja jest w pamieci i szybka, zapis na dysk robi watek WorldStorage
+    std::vector<uint8_t> data;
+    chunk.Serialize(data);
+    m_storage->SaveSnapshot(chunkPos, std::move(data), sequence);
+    ++m_stats.m_snapshots;
+}
@@ -0,0 +1,119 @@
+#include "ChunkMesh.h"
+#include "MeshBuffer.h"
+
+#include <utility>
+
+void ChunkMeshData::Clear() {
+	m_vertices.clear();
+	m_ranges.clear();
+}
+
+ChunkMesh::ChunkMesh(ChunkMesh&& rhs) noexcept
+	: m_buffer(std::exchange(rhs.m_buffer, nullptr))
+	, m_first(std::exchange(rhs.m_first, 0))
+	, m_vertexCount(std::exchange(rhs.m_vertexCount, 0))
+	, m_ranges(std::move(rhs.m_ranges)) {
+}
+
+ChunkMesh& ChunkMesh::operator=(ChunkMesh&& rhs) noexcept {
+	if (&rhs == this) {
+		return *this;
+	}
+
+	Free();
+
+	m_buffer = std::exchange(rhs.m_buffer, nullptr);
+	m_first = std::exchange(rhs.m_first, 0);
+	m_vertexCount = std::exchange(rhs.m_vertexCount, 0);
+	m_ranges = std::move(rhs.m_ranges);
+
+	return *this;
+}
+
+ChunkMesh::~ChunkMesh() {
+	Free();
+}
+
+void ChunkMesh::Free() {
+	if (m_buffer) {
+		m_buffer->Free(m_first, m_vertexCount);
+	}
+	m_first = 0;
+	m_vertexCount = 0;
+	m_ranges.clear();
+}
+
+void ChunkMesh::Upload(MeshBuffer& buffer, const CubePalette& palette,
+	const ChunkMeshData* const* sections, size_t sectionCount, float sectionHeight) {
+	// Stary zakres moze byc jeszcze rysowany, wiec nowa siatka zawsze trafia w nowe miejsce
+	Free();
+	m_buffer = &buffer;
+
+	size_t vertexCount = 0;
+	for (size_t section = 0; section < sectionCount; ++section) {
+		vertexCount += sections[section]->m_vertices.size();
+	}
+	if (vertexCount == 0) {
+		return;
+	}
+
+	m_vertexCount = static_cast<uint32_t>(vertexCount);
+	m_first = buffer.Allocate(m_vertexCount);
+	ChunkVertex* vertices = buffer.Map(m_first, m_vertexCount);
+
+	uint32_t first = 0;
+	for (size_t section = 0; section < sectionCount; ++section) {
+		const ChunkMeshData& data = *sections[section];
+		if (data.m_vertices.empty()) {
+			continue;
+		}
+
+		m_ranges.push_back(Range{
+			static_cast<uint32_t>(section),
+			m_first + first,
+			static_cast<uint32_t>(data.m_vertices.size()) });
+
+		const float offset = static_cast<float>(section) * sectionHeight;
+		for (const ChunkMeshData::Range& range : data.m_ranges) {
+			const float layer = palette.Layer(range.m_type);
+			for (uint32_t i = 0; i < range.m_count; ++i) {
+				ChunkVertex& vertex = vertices[first++];
+				vertex = data.m_vertices[range.m_first + i];
+				vertex.m_position.y += offset;
+				vertex.m_layer = layer;
+			}
+		}
+	}
+
+	buffer.Commit(m_first, m_vertexCount);
+}
+
+size_t ChunkMesh::Draw(const glm::vec3& origin, const uint8_t* isSectionVisible) const {
+	if (!m_buffer || m_vertexCount == 0) {
+		return 0;
+	}
+
+	size_t drawCount = 0;
+
+	// Laczenie sasiednich widocznych sekcji w jedna komende
+	size_t i = 0;
+	while (i < m_ranges.size()) {
+		if (!isSectionVisible[m_ranges[i].m_section]) {
+			++i;
+			continue;
+		}
+
+		const uint32_t first = m_ranges[i].m_first;
+		uint32_t count = m_ranges[i].m_count;
+		++i;
+		while (i < m_ranges.size() && isSectionVisible[m_ranges[i].m_section]) {
+			count += m_ranges[i].m_count;
+			++i;
+		}
+
+		m_buffer->AddDraw(first, count, origin);
+		++drawCount;
+	}
+
+	return drawCount;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "Cube.h"
+#include "CubePalette.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/** Single vertex of a chunk mesh.
+ * Position is in chunk local coordinates. Texture coordinates are expressed in blocks,
+ * so a merged quad repeats its face tile once per block it covers. The texture array layer
+ * is filled in by ChunkMesh::Upload from the palette.
+ */
+struct ChunkVertex {
+	glm::vec3 m_position;
+	glm::vec2 m_texCoord;
+	float m_face;
+	float m_layer;
+};
+
+/** CPU side of a chunk mesh. Vertices are grouped by cube type, each group is described by a range. */
+struct ChunkMeshData {
+	struct Range {
+		Cube::Type m_type;
+		uint32_t m_first;
+		uint32_t m_count;
+	};
+
+	void Clear();
+
+	std::vector<ChunkVertex> m_vertices;
+	std::vector<Range> m_ranges;
+};
+
+class MeshBuffer;
+
+/** GPU side of a chunk mesh - one range of the shared MeshBuffer holding all faces of all
+ * sections of a chunk.
+ * Vertices are grouped by section and every vertex carries its texture array layer, so
+ * neighbouring visible sections form a single range and the chunk usually takes one draw.
+ * Vertex positions are chunk local; the chunk origin is passed with every draw and read by the
+ * shader instead of a model matrix uniform.
+ */
+class ChunkMesh {
+public:
+	ChunkMesh() = default;
+	ChunkMesh(const ChunkMesh&) = delete;
+	ChunkMesh& operator=(const ChunkMesh&) = delete;
+	ChunkMesh(ChunkMesh&&) noexcept;
+	ChunkMesh& operator=(ChunkMesh&&) noexcept;
+	~ChunkMesh();
+
+	/** Replaces the mesh with meshes of sectionCount sections in a new range of buffer,
+	 * sections[i] is drawn i * sectionHeight blocks above the chunk origin. The old range is
+	 * freed, the GPU may still be drawing it.
+	 */
+	void Upload(MeshBuffer& buffer, const CubePalette& palette,
+		const ChunkMeshData* const* sections, size_t sectionCount, float sectionHeight);
+
+	/** Adds draws of sections with a non-zero entry in isSectionVisible, one byte per section,
+	 * to the buffer the mesh was uploaded to. Returns the number of draws added.
+	 */
+	size_t Draw(const glm::vec3& origin, const uint8_t* isSectionVisible) const;
+
+	size_t VertexCount() const { return m_vertexCount; }
+
+private:
+	struct Range {
+		uint32_t m_section;
+		uint32_t m_first;
+		uint32_t m_count;
+	};
+
+	void Free();
+
+	MeshBuffer* m_buffer{ nullptr };
+	uint32_t m_first{ 0 };
+	uint32_t m_vertexCount{ 0 };
+	std::vector<Range> m_ranges;
+};
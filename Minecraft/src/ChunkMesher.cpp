@@ -0,0 +1,90 @@
+#include "ChunkMesher.h"
+
+namespace {
+	/** Orientation of the face tile in the cube texture, matching Cube::s_vertices.
+	 * Texture u coordinate runs along uAxis (reversed when uFlip is set), v along vAxis.
+	 */
+	struct FaceTexture {
+		int uAxis;
+		bool uFlip;
+		int vAxis;
+		bool vFlip;
+	};
+
+	constexpr std::array<FaceTexture, Cube::s_faceCount> s_faceTextures = { {
+		{ 0, false, 1, false },	// Back
+		{ 0, false, 1, true },	// Front
+		{ 1, true,  2, true },	// Left
+		{ 1, false, 2, true },	// Right
+		{ 2, true,  0, false },	// Bottom
+		{ 0, false, 2, false },	// Top
+	} };
+}
+
+void ChunkMesher::EmitQuad(Cube::Type type, Cube::Face face, int axis, int slice,
+	int u, int v, int width, int height) {
+	const int uAxis = (axis + 1) % 3;
+	const int vAxis = (axis + 2) % 3;
+	const FaceTexture& texture = s_faceTextures[static_cast<size_t>(face)];
+
+	glm::ivec3 origin(0);
+	origin[axis] = slice;
+	origin[uAxis] = u;
+	origin[vAxis] = v;
+
+	glm::ivec3 extent(0);
+	extent[uAxis] = width;
+	extent[vAxis] = height;
+
+	const std::array<glm::ivec2, 4> corners = { {
+		{ 0, 0 }, { width, 0 }, { width, height }, { 0, height }
+	} };
+
+	// Sciany z tylu maja odwrocona kolejnosc wierzcholkow, zeby zachowac orientacje CCW
+	const bool isBack = static_cast<int>(face) % 2 == 0;
+	const std::array<int, 6> order = isBack
+		? std::array<int, 6>{ 0, 3, 2, 0, 2, 1 }
+		: std::array<int, 6>{ 0, 1, 2, 0, 2, 3 };
+
+	std::vector<ChunkVertex>& bucket = m_buckets[static_cast<size_t>(type)];
+	for (int corner : order) {
+		glm::ivec3 offset(0);
+		offset[uAxis] = corners[corner].x;
+		offset[vAxis] = corners[corner].y;
+
+		const float s = static_cast<float>(texture.uFlip
+			? extent[texture.uAxis] - offset[texture.uAxis] : offset[texture.uAxis]);
+		const float t = static_cast<float>(texture.vFlip
+			? extent[texture.vAxis] - offset[texture.vAxis] : offset[texture.vAxis]);
+
+		bucket.push_back(ChunkVertex{
+			glm::vec3(origin + offset),
+			glm::vec2(s, t),
+			static_cast<float>(face),
+			0.0f });
+	}
+}
+
+void ChunkMesher::Finish(ChunkMeshData& mesh) {
+	mesh.Clear();
+
+	size_t vertexCount = 0;
+	for (const std::vector<ChunkVertex>& bucket : m_buckets) {
+		vertexCount += bucket.size();
+	}
+	mesh.m_vertices.reserve(vertexCount);
+
+	for (size_t type = 0; type < m_buckets.size(); ++type) {
+		std::vector<ChunkVertex>& bucket = m_buckets[type];
+		if (bucket.empty()) {
+			continue;
+		}
+
+		mesh.m_ranges.push_back(ChunkMeshData::Range{
+			static_cast<Cube::Type>(type),
+			static_cast<uint32_t>(mesh.m_vertices.size()),
+			static_cast<uint32_t>(bucket.size()) });
+		mesh.m_vertices.insert(mesh.m_vertices.end(), bucket.begin(), bucket.end());
+		bucket.clear();
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Cube.h"
+#include "ChunkMesh.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+/** Builds chunk meshes on the CPU using greedy meshing.
+ * Only faces marked as visible are emitted and coplanar faces of the same cube type are
+ * merged into maximal rectangles. Mesher keeps its scratch buffers between calls, so one
+ * instance should be reused for many chunks.
+ */
+class ChunkMesher {
+public:
+	struct Cell {
+		Cube::Type m_type;
+		uint8_t m_visibleFaces;	// bitmask of Cube::FaceMask()
+	};
+
+	/** Builds mesh of a Width x Height x Depth block of cubes.
+	 * cellAt(glm::ivec3(x, y, z)) returns type and visible faces of the cube at given local coordinates.
+	 */
+	template <uint8_t Depth, uint8_t Width, uint8_t Height, typename CellAt>
+	void Build(const CellAt& cellAt, ChunkMeshData& mesh);
+
+private:
+	void EmitQuad(Cube::Type type, Cube::Face face, int axis, int slice,
+		int u, int v, int width, int height);
+	void Finish(ChunkMeshData& mesh);
+
+	std::array<std::vector<ChunkVertex>, Cube::s_typeCount> m_buckets;
+	std::vector<Cube::Type> m_mask;
+};
+
+template <uint8_t Depth, uint8_t Width, uint8_t Height, typename CellAt>
+inline void ChunkMesher::Build(const CellAt& cellAt, ChunkMeshData& mesh) {
+	const glm::ivec3 size(Width, Height, Depth);
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const int uAxis = (axis + 1) % 3;
+		const int vAxis = (axis + 2) % 3;
+		m_mask.resize(static_cast<size_t>(size[uAxis]) * size[vAxis]);
+
+		for (int back = 0; back < 2; ++back) {
+			const Cube::Face face = static_cast<Cube::Face>(
+				(axis == 2 ? 0 : axis == 0 ? 2 : 4) + (back ? 0 : 1));
+			const uint8_t faceMask = Cube::FaceMask(face);
+
+			for (int slice = 0; slice < size[axis]; ++slice) {
+				glm::ivec3 cell(0);
+				cell[axis] = slice;
+
+				for (int v = 0; v < size[vAxis]; ++v) {
+					cell[vAxis] = v;
+					for (int u = 0; u < size[uAxis]; ++u) {
+						cell[uAxis] = u;
+						const Cell data = cellAt(cell);
+						m_mask[v * size[uAxis] + u] = (data.m_visibleFaces & faceMask) ? data.m_type : Cube::Type::None;
+					}
+				}
+
+				// Laczenie scian w maksymalne prostokaty
+				for (int v = 0; v < size[vAxis]; ++v) {
+					for (int u = 0; u < size[uAxis];) {
+						const Cube::Type type = m_mask[v * size[uAxis] + u];
+						if (type == Cube::Type::None) {
+							++u;
+							continue;
+						}
+
+						int width = 1;
+						while (u + width < size[uAxis] && m_mask[v * size[uAxis] + u + width] == type) {
+							++width;
+						}
+
+						int height = 1;
+						for (; v + height < size[vAxis]; ++height) {
+							bool isRowEqual = true;
+							for (int k = 0; k < width && isRowEqual; ++k) {
+								isRowEqual = m_mask[(v + height) * size[uAxis] + u + k] == type;
+							}
+							if (!isRowEqual) {
+								break;
+							}
+						}
+
+						EmitQuad(type, face, axis, back ? slice : slice + 1, u, v, width, height);
+
+						for (int h = 0; h < height; ++h) {
+							for (int k = 0; k < width; ++k) {
+								m_mask[(v + h) * size[uAxis] + u + k] = Cube::Type::None;
+							}
+						}
+						u += width;
+					}
+				}
+			}
+		}
+	}
+
+	Finish(mesh);
+}
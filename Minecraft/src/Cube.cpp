@@ -1,4 +1,5 @@
 #include "Cube.h"
+#include "GLHelpers.h"
 #include <iostream>
 #include <SFML/Graphics.hpp>
 
@@ -47,7 +48,6 @@ std::array<float, 6 * 6 * 5> Cube::s_vertices = {
         -0.5f,  0.5f, -0.5f,  0.25f, 1.0f / 3.0f
 };
 
-extern GLuint CreateTexture(const std::string& path); // Deklaracja funkcji, eby mona byo jej uy
 
 Cube::Cube(const std::string& texturePath) {
 	// Tworzenie i konfiguracja VAO i VBO
@@ -3,16 +3,32 @@
 
 #include <string>
 #include <array>
+#include <cstddef>
+#include <cstdint>
 
 class Cube {
 public:
 
-	enum class Type {
+	enum class Type : uint8_t {
 		None,
 		Grass,
 		Stone,
 		GrassDebug
 	};
+	static constexpr size_t s_typeCount = 4;
+
+	/** Cube faces, in the same order as they are laid out in s_vertices. */
+	enum class Face {
+		Back,	// -Z
+		Front,	// +Z
+		Left,	// -X
+		Right,	// +X
+		Bottom,	// -Y
+		Top		// +Y
+	};
+	static constexpr size_t s_faceCount = 6;
+
+	static constexpr uint8_t FaceMask(Face face) { return static_cast<uint8_t>(1 << static_cast<int>(face)); }
 
 	Cube(const std::string& texturePath);
 
@@ -1,33 +1,27 @@
 #include "CubePalette.h"
-#include "Cube.h"
-#include <iostream>
-#include <SFML/Graphics.hpp>
-#include <ShaderProgram.h>
-
+#include "GLHelpers.h"
 
+#include <string>
+#include <utility>
+#include <vector>
 
 CubePalette::CubePalette()
 {
-	Cube grass("assets/blocks/grass.jpg");
-	Cube stone("assets/blocks/stone.jpg");
-	Cube grass_debug("assets/blocks/grass_debug.jpg");
-	m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::Stone, std::move(stone)));
-	m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::Grass, std::move(grass)));
-	m_palette.insert(std::pair<Cube::Type, Cube>(Cube::Type::GrassDebug, std::move(grass_debug)));
-	/*
-	m_palette[Cube::Type::Grass] = Cube("assets/blocks/grass.png");
-	m_palette[Cube::Type::Stone] = Cube("assets/blocks/stone.png");
-	m_palette[Cube::Type::GrassDebug] = Cube("assets/blocks/grass_debug.png");
-	*/
+	const std::array<std::pair<Cube::Type, std::string>, 3> textures = { {
+		{ Cube::Type::Grass, "assets/blocks/grass.jpg" },
+		{ Cube::Type::Stone, "assets/blocks/stone.jpg" },
+		{ Cube::Type::GrassDebug, "assets/blocks/grass_debug.jpg" }
+	} };
 
+	std::vector<std::string> paths;
+	for (const auto& [type, path] : textures) {
+		m_layers[static_cast<size_t>(type)] = static_cast<float>(paths.size());
+		paths.push_back(path);
+	}
+	m_texture = CreateTextureArray(paths);
 }
 
-
-
-const Cube& CubePalette::LookUp(Cube::Type type) const
+CubePalette::~CubePalette()
 {
-	return m_palette.at(type);
-	
-	
-	
+	if (m_texture) glDeleteTextures(1, &m_texture);
 }
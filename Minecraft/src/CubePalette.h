@@ -2,14 +2,27 @@
 
 #include "Cube.h"
 
-#include <unordered_map>
+#include <glad/glad.h>
 
+#include <array>
+
+/** Textures of all cube types packed into one GL_TEXTURE_2D_ARRAY, one layer per type,
+ * so a chunk mesh with any mix of types is drawn with a single texture bind.
+ */
 class CubePalette {
 public:
 	CubePalette();
 
-	const Cube& LookUp(Cube::Type type) const;
+	CubePalette(const CubePalette&) = delete;
+	CubePalette& operator=(const CubePalette&) = delete;
+	~CubePalette();
+
+	GLuint Texture() const { return m_texture; }
+
+	/** Layer of the texture array holding the texture of given type. */
+	float Layer(Cube::Type type) const { return m_layers[static_cast<size_t>(type)]; }
 
 private:
-	std::unordered_map<Cube::Type, Cube> m_palette;
+	GLuint m_texture{ 0 };
+	std::array<float, Cube::s_typeCount> m_layers{};
 };
\ No newline at end of file
@@ -0,0 +1,247 @@
+#include "EditJournal.h"
+#include "FileSync.h"
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+
+namespace {
+	uint32_t ReadUint32(const uint8_t* bytes) {
+		return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+			| static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+	}
+
+	void WriteUint32(uint32_t value, uint8_t* bytes) {
+		for (int i = 0; i < 4; ++i) {
+			bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+		}
+	}
+
+	/** Low 16 bits of FNV-1a of the record without its checksum. */
+	uint16_t Checksum(const uint8_t* record) {
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < 14; ++i) {
+			hash = (hash ^ record[i]) * 16777619u;
+		}
+		return static_cast<uint16_t>(hash);
+	}
+
+	/** Writes bytes and waits until the system puts them on the disk. */
+	bool WriteAndSync(std::FILE* file, const std::vector<uint8_t>& bytes) {
+		if (!file) {
+			return false;
+		}
+		if (!bytes.empty() && std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size()) {
+			return false;
+		}
+		return SyncFile(file);
+	}
+}
+
+EditJournal::EditJournal(const std::filesystem::path& path)
+	: m_path(path) {
+	ReadFile();
+	m_file = std::fopen(m_path.string().c_str(), "ab");
+	m_writer = std::thread(&EditJournal::WriterLoop, this);
+}
+
+EditJournal::~EditJournal() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_condition.notify_one();
+	m_writer.join();
+
+	if (m_file) {
+		std::fclose(m_file);
+	}
+}
+
+uint64_t EditJournal::Append(const glm::ivec2& chunkPos, uint32_t block, uint8_t type) {
+	uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		sequence = m_nextSequence++;
+		const Key key = KeyOf(chunkPos);
+		const Edit edit{ sequence, block, type };
+		m_edits[key].push_back(edit);
+		++m_liveRecords;
+
+		m_pending.resize(m_pending.size() + s_recordSize);
+		Encode(key, edit, m_pending.data() + m_pending.size() - s_recordSize);
+	}
+	m_condition.notify_one();
+	return sequence;
+}
+
+size_t EditJournal::EditCount(const glm::ivec2& chunkPos) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_edits.find(KeyOf(chunkPos));
+	return it != m_edits.end() ? it->second.size() : 0;
+}
+
+uint64_t EditJournal::LastSequence(const glm::ivec2& chunkPos) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_edits.find(KeyOf(chunkPos));
+	return it != m_edits.end() ? it->second.back().m_sequence : 0;
+}
+
+void EditJournal::Drop(const glm::ivec2& chunkPos, uint64_t sequence) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_edits.find(KeyOf(chunkPos));
+	if (it == m_edits.end()) {
+		return;
+	}
+
+	// Edycje chunka sa posortowane wedlug numeru, wiec usuwamy poczatek wektora
+	std::vector<Edit>& edits = it->second;
+	auto last = std::find_if(edits.begin(), edits.end(),
+		[sequence](const Edit& edit) { return edit.m_sequence > sequence; });
+	m_liveRecords -= static_cast<size_t>(last - edits.begin());
+	edits.erase(edits.begin(), last);
+	if (edits.empty()) {
+		m_edits.erase(it);
+	}
+}
+
+void EditJournal::Sync() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	const uint64_t sequence = m_nextSequence - 1;
+	m_isSyncRequested = true;
+	m_condition.notify_one();
+	m_syncedCondition.wait(lock, [this, sequence]() { return m_syncedSequence >= sequence; });
+}
+
+size_t EditJournal::LiveRecords() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_liveRecords;
+}
+
+size_t EditJournal::FileRecords() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_fileRecords;
+}
+
+void EditJournal::Encode(const Key& chunk, const Edit& edit, uint8_t* record) {
+	WriteUint32(static_cast<uint32_t>(chunk.first), record);
+	WriteUint32(static_cast<uint32_t>(chunk.second), record + 4);
+	WriteUint32(edit.m_block, record + 8);
+	record[12] = edit.m_type;
+	record[13] = 0;
+	const uint16_t checksum = Checksum(record);
+	record[14] = static_cast<uint8_t>(checksum);
+	record[15] = static_cast<uint8_t>(checksum >> 8);
+}
+
+void EditJournal::ReadFile() {
+	std::ifstream file(m_path, std::ios::binary);
+	if (!file) {
+		return;
+	}
+	const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+
+	size_t offset = 0;
+	for (; offset + s_recordSize <= bytes.size(); offset += s_recordSize) {
+		const uint8_t* record = &bytes[offset];
+		if (Checksum(record) != (record[14] | record[15] << 8)) {
+			break;
+		}
+
+		const Key key(static_cast<int32_t>(ReadUint32(record)), static_cast<int32_t>(ReadUint32(record + 4)));
+		m_edits[key].push_back(Edit{ m_nextSequence++, ReadUint32(record + 8), record[12] });
+		++m_liveRecords;
+		++m_fileRecords;
+	}
+	m_syncedSequence = m_nextSequence - 1;
+
+	// Rekord przerwany przez awarie - obcinamy go, zeby kolejne dopisane rekordy byly czytelne
+	if (offset != bytes.size()) {
+		std::error_code error;
+		std::filesystem::resize_file(m_path, offset, error);
+	}
+}
+
+void EditJournal::WriterLoop() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_condition.wait(lock, [this]() { return m_isStopping || m_isSyncRequested || !m_pending.empty(); });
+
+		// Zbieramy rekordy przez s_syncInterval, zeby jeden fsync objal wiele edycji
+		if (!m_isStopping && !m_isSyncRequested) {
+			m_condition.wait_for(lock, s_syncInterval, [this]() { return m_isStopping || m_isSyncRequested; });
+		}
+		m_isSyncRequested = false;
+
+		const uint64_t sequence = m_nextSequence - 1;
+		const bool isRewrite = m_fileRecords >= s_minRecordsToRewrite && m_liveRecords * 2 < m_fileRecords;
+		std::vector<uint8_t> bytes;
+		if (isRewrite) {
+			// Plik z samymi zywymi rekordami zawiera tez te czekajace na zapis
+			std::vector<std::pair<Key, Edit>> edits;
+			edits.reserve(m_liveRecords);
+			for (const auto& [key, chunkEdits] : m_edits) {
+				for (const Edit& edit : chunkEdits) {
+					edits.emplace_back(key, edit);
+				}
+			}
+			std::sort(edits.begin(), edits.end(), [](const auto& lhs, const auto& rhs) {
+				return lhs.second.m_sequence < rhs.second.m_sequence;
+			});
+
+			bytes.resize(edits.size() * s_recordSize);
+			for (size_t i = 0; i < edits.size(); ++i) {
+				Encode(edits[i].first, edits[i].second, &bytes[i * s_recordSize]);
+			}
+			m_pending.clear();
+		}
+		else {
+			bytes.swap(m_pending);
+		}
+		lock.unlock();
+
+		const bool isRewritten = isRewrite && Rewrite(bytes);
+		if (!isRewrite) {
+			WriteAndSync(m_file, bytes);
+		}
+
+		lock.lock();
+		const size_t records = bytes.size() / s_recordSize;
+		m_fileRecords = isRewritten ? records : m_fileRecords + records;
+		m_syncedSequence = sequence;
+		m_syncedCondition.notify_all();
+
+		if (m_isStopping && m_pending.empty()) {
+			break;
+		}
+	}
+}
+
+bool EditJournal::Rewrite(const std::vector<uint8_t>& bytes) {
+	std::filesystem::path temporary = m_path;
+	temporary += ".tmp";
+
+	std::FILE* file = std::fopen(temporary.string().c_str(), "wb");
+	const bool isWritten = WriteAndSync(file, bytes);
+	if (file) {
+		std::fclose(file);
+	}
+
+	std::error_code error;
+	if (isWritten) {
+		if (m_file) {
+			std::fclose(m_file);
+		}
+		std::filesystem::rename(temporary, m_path, error);
+		m_file = std::fopen(m_path.string().c_str(), "ab");
+		if (!error) {
+			return true;
+		}
+	}
+
+	// Nie udalo sie podmienic pliku - dopisujemy zywe rekordy na koncu, odtworzenie da ten sam wynik
+	std::filesystem::remove(temporary, error);
+	WriteAndSync(m_file, bytes);
+	return false;
+}
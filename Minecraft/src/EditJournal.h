@@ -0,0 +1,111 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/** Append only log of single block edits, so an edit costs one small sequential write
+ * instead of rewriting the whole chunk.
+ * Every record is 16 bytes: chunk X, chunk Z, block index inside the chunk, new type and a
+ * checksum. Appended records are buffered and written by a background thread, which calls
+ * fsync once per batch (at most every s_syncInterval), so an edit is durable after at most
+ * s_syncInterval and a crash can lose only the last batch. A torn record at the end of the file
+ * is cut off when the journal is opened.
+ * All edits are also kept in memory, per chunk, to be replayed over generated or saved blocks.
+ * Once a chunk has a snapshot containing its edits they are dropped with Drop; when most of the
+ * file consists of dropped records the background thread rewrites it with the live ones only.
+ */
+class EditJournal {
+public:
+	static constexpr std::chrono::milliseconds s_syncInterval{ 100 };
+
+	/** Opens the journal, replaying records already in the file into memory. */
+	explicit EditJournal(const std::filesystem::path& path);
+
+	/** Writes and syncs everything appended so far. */
+	~EditJournal();
+
+	EditJournal(const EditJournal&) = delete;
+	EditJournal& operator=(const EditJournal&) = delete;
+
+	/** Records an edit. Returns the sequence number of the edit, increasing with every call. */
+	uint64_t Append(const glm::ivec2& chunkPos, uint32_t block, uint8_t type);
+
+	/** Calls apply(uint32_t block, uint8_t type) for every live edit of the chunk, oldest first. */
+	template <typename Apply>
+	void Replay(const glm::ivec2& chunkPos, Apply&& apply) const;
+
+	/** Number of live edits of the chunk. */
+	size_t EditCount(const glm::ivec2& chunkPos) const;
+
+	/** Sequence number of the newest edit of the chunk, 0 if there is none. */
+	uint64_t LastSequence(const glm::ivec2& chunkPos) const;
+
+	/** Drops edits of the chunk up to and including given sequence number, they are in a snapshot now. */
+	void Drop(const glm::ivec2& chunkPos, uint64_t sequence);
+
+	/** Waits until everything appended so far is written and synced. */
+	void Sync();
+
+	size_t LiveRecords() const;
+	size_t FileRecords() const;
+
+private:
+	using Key = std::pair<int, int>;
+
+	struct Edit {
+		uint64_t m_sequence;
+		uint32_t m_block;
+		uint8_t m_type;
+	};
+
+	static constexpr size_t s_recordSize = 16;
+	static constexpr size_t s_minRecordsToRewrite = 4096;
+
+	static Key KeyOf(const glm::ivec2& position) { return Key(position.x, position.y); }
+	static void Encode(const Key& chunk, const Edit& edit, uint8_t* record);
+
+	void ReadFile();
+	void WriterLoop();
+
+	/** Replaces the file with given records, falls back to appending them if that fails. */
+	bool Rewrite(const std::vector<uint8_t>& bytes);
+
+	std::filesystem::path m_path;
+	std::FILE* m_file{ nullptr };	// tylko watek zapisujacy (i konstruktor/destruktor)
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::condition_variable m_syncedCondition;
+	std::map<Key, std::vector<Edit>> m_edits;
+	std::vector<uint8_t> m_pending;	// zakodowane rekordy czekajace na zapis
+	uint64_t m_nextSequence{ 1 };
+	uint64_t m_syncedSequence{ 0 };	// wszystkie rekordy do tego numeru sa na dysku
+	size_t m_liveRecords{ 0 };
+	size_t m_fileRecords{ 0 };
+	bool m_isSyncRequested{ false };
+	bool m_isStopping{ false };
+
+	std::thread m_writer;
+};
+
+template <typename Apply>
+inline void EditJournal::Replay(const glm::ivec2& chunkPos, Apply&& apply) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_edits.find(KeyOf(chunkPos));
+	if (it == m_edits.end()) {
+		return;
+	}
+	for (const Edit& edit : it->second) {
+		apply(edit.m_block, edit.m_type);
+	}
+}
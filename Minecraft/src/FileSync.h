@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/** Flushes the stream and waits until the system puts the file data on the disk. */
+inline bool SyncFile(std::FILE* file) {
+	if (std::fflush(file) != 0) {
+		return false;
+	}
+#if defined(_WIN32)
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+/** Moves the position of the stream to offset bytes from the start, also past 2 GiB. */
+inline bool SeekFile(std::FILE* file, uint64_t offset) {
+#if defined(_WIN32)
+	return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+	return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
@@ -0,0 +1,25 @@
+#include "Frustum.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// glm przechowuje macierz kolumnami, wiersz i to (m[0][i], m[1][i], m[2][i], m[3][i])
+	const glm::mat4 transposed = glm::transpose(viewProjection);
+	const glm::vec4 x = transposed[0], y = transposed[1], z = transposed[2], w = transposed[3];
+
+	m_planes = { w + x, w - x, w + y, w - y, w + z, w - z };	// lewa, prawa, dol, gora, bliska, daleka
+	for (glm::vec4& plane : m_planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+}
+
+bool Frustum::Intersects(const glm::vec3& min, const glm::vec3& max) const {
+	for (const glm::vec4& plane : m_planes) {
+		// Wierzcholek pudelka najdalej w strone normalnej - jesli on jest za plaszczyzna, cale pudelko tez
+		const float x = plane.x >= 0.0f ? max.x : min.x;
+		const float y = plane.y >= 0.0f ? max.y : min.y;
+		const float z = plane.z >= 0.0f ? max.z : min.z;
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
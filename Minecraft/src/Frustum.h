@@ -0,0 +1,24 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <array>
+
+/** View frustum as six planes extracted from a projection * view matrix (Gribb & Hartmann).
+ * Planes point inwards and are normalized, a point p is inside when dot(plane.xyz, p) + plane.w >= 0
+ * for every plane. Boxes are tested conservatively: a box is culled only if it lies completely
+ * behind one of the planes, so a few boxes near the frustum corners are kept although outside.
+ */
+class Frustum {
+public:
+	static constexpr size_t s_planeCount = 6;
+
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	/** Tells whether the box can be visible (not completely outside of any plane). */
+	bool Intersects(const glm::vec3& min, const glm::vec3& max) const;
+
+	const std::array<glm::vec4, s_planeCount>& Planes() const { return m_planes; }
+
+private:
+	std::array<glm::vec4, s_planeCount> m_planes;
+};
@@ -0,0 +1,130 @@
+#include "GLHelpers.h"
+
+#include <SFML/Graphics.hpp>
+
+#include <cstdint>
+#include <future>
+#include <iostream>
+
+// Linkowanie programu
+GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader)
+{
+    const GLuint programId = glCreateProgram();
+    if (!programId) {
+        std::cerr << "Error creating shader program " << std::endl;
+        return 0;   // null handle 
+    }
+
+    glAttachShader(programId, vertexShader);
+    glAttachShader(programId, fragmentShader);
+    if (geometryShader) glAttachShader(programId, geometryShader);
+
+    glLinkProgram(programId);
+
+    return programId;
+}
+
+// Kompilacja shaderow
+GLuint CreateShader(const GLchar* shaderSource, GLenum shaderType) {
+    const GLuint shaderId = glCreateShader(shaderType);
+    if (!shaderId) {
+        std::cerr << "Error creating shader! (shaderId do not exists)" << std::endl;
+        return 0;   // null handle 
+    }
+
+    glShaderSource(shaderId, 1, &shaderSource, nullptr);
+    glCompileShader(shaderId);
+
+    // error handling 
+    GLint success;
+    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        std::cerr << "Shader compilation failed" << std::endl;
+        return 0;
+    }
+
+    return shaderId;
+}
+
+// Tworzenie tekstury
+GLuint CreateTexture(const std::string& path) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    sf::Image image;
+    if (image.loadFromFile(path)) {
+        image.flipVertically();
+        const sf::Vector2u size = image.getSize();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.getPixelsPtr());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    else {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+    }
+
+    return texture;
+}
+
+// Tworzenie tablicy tekstur
+GLuint CreateTextureArray(const std::vector<std::string>& paths) {
+    // Dekodowanie plikow rownolegle, wywolania GL tylko w biezacym watku
+    std::vector<std::future<sf::Image>> decoded;
+    decoded.reserve(paths.size());
+    for (const std::string& path : paths) {
+        decoded.push_back(std::async(std::launch::async, [&path]() {
+            sf::Image image;
+            if (image.loadFromFile(path)) {
+                image.flipVertically();
+            }
+            return image;
+            }));
+    }
+
+    std::vector<sf::Image> images;
+    images.reserve(paths.size());
+    for (std::future<sf::Image>& image : decoded) {
+        images.push_back(image.get());
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    sf::Vector2u size(0, 0);
+    for (const sf::Image& image : images) {
+        if (image.getSize().x != 0) {
+            size = image.getSize();
+            break;
+        }
+    }
+
+    // Pusta tablica wypelniona zerami, warstwy wgrywane osobno
+    const std::vector<uint8_t> clear(static_cast<size_t>(size.x) * size.y * 4 * paths.size(), 0);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, size.x, size.y, static_cast<GLsizei>(paths.size()), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, clear.data());
+
+    for (size_t layer = 0; layer < images.size(); ++layer) {
+        if (images[layer].getSize() != size || size.x == 0) {
+            std::cerr << "Failed to load texture: " << paths[layer] << std::endl;
+            continue;
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(layer), size.x, size.y, 1,
+            GL_RGBA, GL_UNSIGNED_BYTE, images[layer].getPixelsPtr());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    return texture;
+}
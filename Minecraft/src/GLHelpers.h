@@ -0,0 +1,20 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+/** Links a program from compiled shaders, geometryShader is optional. Returns 0 on failure. */
+GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = 0);
+
+/** Compiles a shader of given type. Returns 0 on failure. */
+GLuint CreateShader(const GLchar* shaderSource, GLenum shaderType);
+
+/** Loads an image file into a mipmapped 2D texture. */
+GLuint CreateTexture(const std::string& path);
+
+/** Loads image files into layers of a mipmapped 2D texture array, layer i holds paths[i].
+ * Images are decoded in parallel and must all have the size of the first one; a layer whose
+ * image cannot be loaded stays transparent.
+ */
+GLuint CreateTextureArray(const std::vector<std::string>& paths);
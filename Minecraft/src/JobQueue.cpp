@@ -0,0 +1,93 @@
+#include "JobQueue.h"
+
+#include <algorithm>
+
+namespace {
+	int DistanceSquared(const glm::ivec2& a, const glm::ivec2& b) {
+		const glm::ivec2 delta = a - b;
+		return delta.x * delta.x + delta.y * delta.y;
+	}
+}
+
+JobQueue::JobQueue(size_t workerCount, size_t capacity)
+	: m_capacity(capacity) {
+	m_jobs.reserve(capacity);
+	for (size_t i = 0; i < std::max<size_t>(workerCount, 1); ++i) {
+		m_workers.emplace_back(&JobQueue::WorkerLoop, this);
+	}
+}
+
+JobQueue::~JobQueue() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_condition.notify_all();
+
+	for (std::thread& worker : m_workers) {
+		worker.join();
+	}
+}
+
+bool JobQueue::Push(const glm::ivec2& key, Task task) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_jobs.size() >= m_capacity) {
+			return false;
+		}
+		m_jobs.push_back(Job{ key, std::move(task) });
+	}
+	m_condition.notify_one();
+	return true;
+}
+
+bool JobQueue::Cancel(const glm::ivec2& key) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = std::find_if(m_jobs.begin(), m_jobs.end(),
+		[&key](const Job& job) { return job.m_key == key; });
+	if (it == m_jobs.end()) {
+		return false;
+	}
+
+	if (it != m_jobs.end() - 1) {
+		*it = std::move(m_jobs.back());
+	}
+	m_jobs.pop_back();
+	return true;
+}
+
+void JobQueue::SetFocus(const glm::ivec2& focus) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_focus = focus;
+}
+
+size_t JobQueue::Size() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_jobs.size();
+}
+
+void JobQueue::WorkerLoop() {
+	for (;;) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_isStopping || !m_jobs.empty(); });
+			if (m_isStopping) {
+				return;
+			}
+
+			// Najpierw zadania najblizej gracza
+			auto closest = std::min_element(m_jobs.begin(), m_jobs.end(),
+				[this](const Job& lhs, const Job& rhs) {
+					return DistanceSquared(lhs.m_key, m_focus) < DistanceSquared(rhs.m_key, m_focus);
+				});
+			task = std::move(closest->m_task);
+			if (closest != m_jobs.end() - 1) {
+				*closest = std::move(m_jobs.back());
+			}
+			m_jobs.pop_back();
+		}
+
+		task();
+	}
+}
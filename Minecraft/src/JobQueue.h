@@ -0,0 +1,52 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Bounded queue of jobs executed by a pool of worker threads.
+ * Every job is keyed by a chunk coordinate. Workers always pick the queued job closest to
+ * the current focus (usually the chunk the player stands in), so jobs near the player run
+ * first even if the player moved since they were pushed.
+ */
+class JobQueue {
+public:
+	using Task = std::function<void()>;
+
+	JobQueue(size_t workerCount, size_t capacity);
+	~JobQueue();
+
+	JobQueue(const JobQueue&) = delete;
+	JobQueue& operator=(const JobQueue&) = delete;
+
+	/** Returns false if the queue is full, the job should then be pushed again later. */
+	bool Push(const glm::ivec2& key, Task task);
+
+	/** Removes a job which has not started yet. Returns false if there is no such job. */
+	bool Cancel(const glm::ivec2& key);
+
+	void SetFocus(const glm::ivec2& focus);
+
+	size_t Size() const;
+	size_t Capacity() const { return m_capacity; }
+
+private:
+	struct Job {
+		glm::ivec2 m_key;
+		Task m_task;
+	};
+
+	void WorkerLoop();
+
+	std::vector<Job> m_jobs;
+	std::vector<std::thread> m_workers;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	glm::ivec2 m_focus{ 0 };
+	size_t m_capacity;
+	bool m_isStopping{ false };
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/** Whole file mapped read only into memory (mmap / MapViewOfFile).
+ * Data is read straight from the page cache, without copying it into a separate buffer.
+ * The file must not be written while it is mapped - writers Close the mapping first and
+ * Open it again afterwards.
+ */
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** Maps the file, closing the previous mapping. Returns false if the file can not be mapped. */
+	bool Open(const std::filesystem::path& path);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const uint8_t* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+#if defined(_WIN32)
+	void* m_file{ nullptr };
+	void* m_mapping{ nullptr };
+#endif
+	const uint8_t* m_data{ nullptr };
+	size_t m_size{ 0 };
+};
@@ -0,0 +1,378 @@
+#include "MeshBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+// glad moze byc wygenerowany bez tych wersji - wtedy zostaje sciezka z GL 3.3
+#if defined(GL_VERSION_4_4) || defined(GL_ARB_buffer_storage)
+#define MESH_BUFFER_STORAGE
+#endif
+#if defined(GL_VERSION_4_3)
+#define MESH_BUFFER_INDIRECT
+#endif
+
+namespace {
+#if defined(MESH_BUFFER_STORAGE)
+	constexpr GLbitfield s_storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+#endif
+	constexpr GLuint64 s_fenceTimeout = 1000000;  // 1 ms, potem ponowne czekanie
+
+	bool HasBufferStorage() {
+#if defined(GL_VERSION_4_4)
+		if (GLAD_GL_VERSION_4_4) return true;
+#endif
+#if defined(GL_ARB_buffer_storage)
+		if (GLAD_GL_ARB_buffer_storage) return true;
+#endif
+		return false;
+	}
+
+	bool HasMultiDrawIndirect() {
+#if defined(MESH_BUFFER_INDIRECT)
+		// baseInstance w komendach wymaga GL 4.2, samo rozszerzenie ARB_multi_draw_indirect nie wystarcza
+		return GLAD_GL_VERSION_4_3 != 0;
+#else
+		return false;
+#endif
+	}
+}
+
+float MeshBuffer::Stats::Fragmentation() const {
+	if (m_freeVertices == 0) {
+		return 0.0f;
+	}
+	return 1.0f - static_cast<float>(m_largestFreeBlock) / static_cast<float>(m_freeVertices);
+}
+
+MeshBuffer::MeshBuffer(size_t vertexCapacity, size_t maxDraws)
+	: m_capacity(vertexCapacity)
+	, m_maxDraws(maxDraws) {
+	m_frameCommands.reserve(maxDraws);
+	m_frameOrigins.reserve(maxDraws);
+}
+
+MeshBuffer::~MeshBuffer() {
+	for (GLsync fence : m_fences) {
+		if (fence) glDeleteSync(fence);
+	}
+	if (m_copyFence) glDeleteSync(m_copyFence);
+	// Usuniecie bufora zwalnia tez jego mapowanie
+	if (m_vbo) glDeleteBuffers(1, &m_vbo);
+	if (m_commandBuffer) glDeleteBuffers(1, &m_commandBuffer);
+	if (m_originBuffer) glDeleteBuffers(1, &m_originBuffer);
+	if (m_vao) glDeleteVertexArrays(1, &m_vao);
+}
+
+void MeshBuffer::Create() {
+	m_stats.m_isPersistent = HasBufferStorage();
+	m_stats.m_isIndirect = HasMultiDrawIndirect();
+
+	glGenVertexArrays(1, &m_vao);
+	Grow(m_capacity);
+
+#if defined(MESH_BUFFER_INDIRECT)
+	if (m_stats.m_isIndirect) {
+		const GLsizeiptr commandBytes = s_frameCount * m_maxDraws * sizeof(DrawCommand);
+		const GLsizeiptr originBytes = s_frameCount * m_maxDraws * sizeof(glm::vec3);
+		glGenBuffers(1, &m_commandBuffer);
+		glGenBuffers(1, &m_originBuffer);
+
+		glBindVertexArray(m_vao);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_originBuffer);
+#if defined(MESH_BUFFER_STORAGE)
+		if (m_stats.m_isPersistent) {
+			glBufferStorage(GL_DRAW_INDIRECT_BUFFER, commandBytes, nullptr, s_storageFlags);
+			m_commands = static_cast<DrawCommand*>(
+				glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, commandBytes, s_storageFlags));
+			glBufferStorage(GL_ARRAY_BUFFER, originBytes, nullptr, s_storageFlags);
+			m_origins = static_cast<glm::vec3*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, originBytes, s_storageFlags));
+		}
+		else
+#endif
+		{
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, nullptr, GL_STREAM_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, originBytes, nullptr, GL_STREAM_DRAW);
+		}
+
+		// Polozenie chunka - jedna wartosc na komende, wybierana przez baseInstance
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+		glEnableVertexAttribArray(3);
+		glVertexAttribDivisor(3, 1);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+#endif
+}
+
+void MeshBuffer::Grow(size_t vertexCapacity) {
+	const GLsizeiptr bytes = vertexCapacity * sizeof(ChunkVertex);
+	GLuint vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+
+	ChunkVertex* vertices = nullptr;
+#if defined(MESH_BUFFER_STORAGE)
+	if (m_stats.m_isPersistent) {
+		glBufferStorage(GL_COPY_WRITE_BUFFER, bytes, nullptr, s_storageFlags);
+		vertices = static_cast<ChunkVertex*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes, s_storageFlags));
+	}
+	else
+#endif
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	if (m_vbo) {
+		// Kopia po stronie GPU - zakresy siatek i komendy biezacej klatki pozostaja wazne
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_capacity * sizeof(ChunkVertex));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &m_vbo);
+
+		// Zapisy przez mapowanie nie czekaja na kopie - stara czesc jest wydawana dopiero po niej
+		if (vertices) {
+			if (m_copyFence) glDeleteSync(m_copyFence);
+			m_copyFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			m_copyEnd = static_cast<uint32_t>(m_capacity);
+		}
+		Release(Block{ static_cast<uint32_t>(m_capacity), static_cast<uint32_t>(vertexCapacity - m_capacity) });
+	}
+	else {
+		Release(Block{ 0, static_cast<uint32_t>(vertexCapacity) });
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_vbo = vbo;
+	m_vertices = vertices;
+	m_capacity = vertexCapacity;
+	m_stats.m_capacity = vertexCapacity;
+	SetVertexAttributes();
+}
+
+void MeshBuffer::SetVertexAttributes() {
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+	// Pozycje (x, y, z)
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, m_position));
+	glEnableVertexAttribArray(0);
+
+	// Teksturowanie (u, v)
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, m_texCoord));
+	glEnableVertexAttribArray(1);
+
+	// Indeks sciany (Cube::Face)
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, m_face));
+	glEnableVertexAttribArray(2);
+
+	// Warstwa tablicy tekstur (typ kostki)
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ChunkVertex), (void*)offsetof(ChunkVertex, m_layer));
+	glEnableVertexAttribArray(4);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshBuffer::BeginFrame() {
+	m_frame = (m_frame + 1) % s_frameCount;
+	m_stats.m_uploads = 0;
+	m_stats.m_uploadedBytes = 0;
+	m_stats.m_uploadNanoseconds = 0;
+	m_stats.m_fenceWaits = 0;
+
+	GLsync& fence = m_fences[m_frame];
+	if (fence) {
+		// Zwykle GPU juz skonczyl te klatke, czekanie oznacza, ze CPU wyprzedza go o s_frameCount klatek
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			++m_stats.m_fenceWaits;
+			do {
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, s_fenceTimeout);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	if (m_copyEnd != 0 && (!m_copyFence || glClientWaitSync(m_copyFence, 0, 0) != GL_TIMEOUT_EXPIRED)) {
+		if (m_copyFence) glDeleteSync(m_copyFence);
+		m_copyFence = nullptr;
+		m_copyEnd = 0;
+	}
+
+	for (const Block& block : m_pendingFrees[m_frame]) {
+		Release(block);
+	}
+	m_pendingFrees[m_frame].clear();
+
+	m_frameCommands.clear();
+	m_frameOrigins.clear();
+}
+
+uint32_t MeshBuffer::Allocate(uint32_t count) {
+	if (!m_vao) {
+		Create();
+	}
+
+	for (;;) {
+		for (auto block = m_freeBlocks.begin(); block != m_freeBlocks.end(); ++block) {
+			const uint32_t first = std::max(block->m_first, m_copyEnd);
+			const uint32_t end = block->m_first + block->m_count;
+			if (first >= end || end - first < count) {
+				continue;
+			}
+
+			if (first == block->m_first) {
+				block->m_first += count;
+				block->m_count -= count;
+				if (block->m_count == 0) {
+					m_freeBlocks.erase(block);
+				}
+			}
+			else {
+				// Blok zaczyna sie przed koncem kopii - zostaje jego poczatek i ewentualnie reszta za zakresem
+				block->m_count = first - block->m_first;
+				if (first + count < end) {
+					m_freeBlocks.insert(std::next(block), Block{ first + count, end - first - count });
+				}
+			}
+			m_stats.m_usedVertices += count;
+			return first;
+		}
+
+		// Nowa czesc bufora laczy sie z ostatnim wolnym blokiem i jest poza kopia, wiec nastepna proba sie uda
+		Grow(std::max(m_capacity * 2, m_capacity + count));
+	}
+}
+
+void MeshBuffer::Free(uint32_t first, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+	m_pendingFrees[m_frame].push_back(Block{ first, count });
+	m_stats.m_usedVertices -= count;
+}
+
+void MeshBuffer::Release(const Block& block) {
+	auto next = std::lower_bound(m_freeBlocks.begin(), m_freeBlocks.end(), block.m_first,
+		[](const Block& free, uint32_t first) { return free.m_first < first; });
+
+	const bool joinsPrevious = next != m_freeBlocks.begin()
+		&& std::prev(next)->m_first + std::prev(next)->m_count == block.m_first;
+	const bool joinsNext = next != m_freeBlocks.end() && block.m_first + block.m_count == next->m_first;
+
+	if (joinsPrevious && joinsNext) {
+		std::prev(next)->m_count += block.m_count + next->m_count;
+		m_freeBlocks.erase(next);
+	}
+	else if (joinsPrevious) {
+		std::prev(next)->m_count += block.m_count;
+	}
+	else if (joinsNext) {
+		next->m_first = block.m_first;
+		next->m_count += block.m_count;
+	}
+	else {
+		m_freeBlocks.insert(next, block);
+	}
+}
+
+ChunkVertex* MeshBuffer::Map(uint32_t first, uint32_t count) {
+	m_uploadStart = std::chrono::steady_clock::now();
+	if (m_vertices) {
+		return m_vertices + first;
+	}
+	m_staging.resize(count);
+	return m_staging.data();
+}
+
+void MeshBuffer::Commit(uint32_t first, uint32_t count) {
+	if (!m_vertices) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(ChunkVertex), count * sizeof(ChunkVertex), m_staging.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	++m_stats.m_uploads;
+	m_stats.m_uploadedBytes += count * sizeof(ChunkVertex);
+	m_stats.m_uploadNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - m_uploadStart).count();
+}
+
+void MeshBuffer::AddDraw(uint32_t first, uint32_t count, const glm::vec3& origin) {
+	assert(m_frameCommands.size() < m_maxDraws);
+	m_frameCommands.push_back(DrawCommand{
+		count,
+		1,
+		first,
+		static_cast<GLuint>(m_frame * m_maxDraws + m_frameCommands.size()) });
+	m_frameOrigins.push_back(origin);
+}
+
+size_t MeshBuffer::Draw(GLuint texture) {
+	if (!m_vao) {
+		return 0;
+	}
+
+	size_t drawCalls = 0;
+	if (!m_frameCommands.empty()) {
+		glBindVertexArray(m_vao);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+#if defined(MESH_BUFFER_INDIRECT)
+		if (m_stats.m_isIndirect) {
+			// Kazda klatka ma swoja czesc bufora komend, GPU moze jeszcze czytac poprzednie
+			const size_t base = m_frame * m_maxDraws;
+			const size_t count = m_frameCommands.size();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+			if (m_commands) {
+				std::memcpy(m_commands + base, m_frameCommands.data(), count * sizeof(DrawCommand));
+				std::memcpy(m_origins + base, m_frameOrigins.data(), count * sizeof(glm::vec3));
+			}
+			else {
+				glBufferSubData(GL_DRAW_INDIRECT_BUFFER, base * sizeof(DrawCommand), count * sizeof(DrawCommand),
+					m_frameCommands.data());
+				glBindBuffer(GL_ARRAY_BUFFER, m_originBuffer);
+				glBufferSubData(GL_ARRAY_BUFFER, base * sizeof(glm::vec3), count * sizeof(glm::vec3),
+					m_frameOrigins.data());
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+
+			glMultiDrawArraysIndirect(GL_TRIANGLES, (void*)(base * sizeof(DrawCommand)), static_cast<GLsizei>(count), 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			drawCalls = 1;
+		}
+		else
+#endif
+		{
+			// Bez tablicy atrybutu 3 shader dostaje jego biezaca wartosc
+			for (size_t i = 0; i < m_frameCommands.size(); ++i) {
+				const glm::vec3& origin = m_frameOrigins[i];
+				glVertexAttrib3f(3, origin.x, origin.y, origin.z);
+				glDrawArrays(GL_TRIANGLES, static_cast<GLint>(m_frameCommands[i].m_first),
+					static_cast<GLsizei>(m_frameCommands[i].m_count));
+			}
+			drawCalls = m_frameCommands.size();
+		}
+	}
+
+	if (m_fences[m_frame]) {
+		glDeleteSync(m_fences[m_frame]);
+	}
+	m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	m_stats.m_freeBlocks = m_freeBlocks.size();
+	m_stats.m_freeVertices = 0;
+	m_stats.m_largestFreeBlock = 0;
+	for (const Block& block : m_freeBlocks) {
+		m_stats.m_freeVertices += block.m_count;
+		m_stats.m_largestFreeBlock = std::max<size_t>(m_stats.m_largestFreeBlock, block.m_count);
+	}
+
+	return drawCalls;
+}
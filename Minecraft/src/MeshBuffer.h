@@ -0,0 +1,122 @@
+#pragma once
+#include "ChunkMesh.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** One large vertex buffer shared by the meshes of all chunks, so streaming chunks in and out
+ * does not create or delete GL buffers.
+ * Meshes take ranges of the buffer from a first-fit free list; the buffer grows (with a copy on
+ * the GPU) when no free block is large enough. With GL 4.4 or ARB_buffer_storage the buffer is
+ * persistently mapped and meshes are written straight into it, otherwise with glBufferSubData.
+ * Writes through the mapping are not ordered with the copy of a grow, so until the copy has
+ * finished only the new part of the buffer is handed out.
+ * The GPU may still read data of the last s_frameCount frames, so a freed range is reused only
+ * after the fence of the frame it was freed in has signalled, and draw commands of every frame
+ * are written to their own part of a ring.
+ * Draws collected during a frame are issued with one glMultiDrawArraysIndirect on GL 4.3,
+ * one glDrawArrays per draw otherwise. GL objects are created on first use, so the buffer can
+ * be constructed without a GL context.
+ */
+class MeshBuffer {
+public:
+	/** Allocator state and upload counters of the current frame. */
+	struct Stats {
+		size_t m_capacity{ 0 };             // w wierzcholkach
+		size_t m_usedVertices{ 0 };
+		size_t m_freeVertices{ 0 };         // bez zakresow czekajacych na GPU
+		size_t m_freeBlocks{ 0 };
+		size_t m_largestFreeBlock{ 0 };
+		size_t m_uploads{ 0 };
+		size_t m_uploadedBytes{ 0 };
+		uint64_t m_uploadNanoseconds{ 0 };
+		size_t m_fenceWaits{ 0 };           // klatki, w ktorych CPU czekal na GPU
+		bool m_isPersistent{ false };
+		bool m_isIndirect{ false };
+
+		/** Share of free space outside the largest free block, 0 when free space is contiguous. */
+		float Fragmentation() const;
+	};
+
+	static constexpr size_t s_frameCount = 3;
+
+	/** maxDraws is the largest number of AddDraw calls in one frame. */
+	MeshBuffer(size_t vertexCapacity, size_t maxDraws);
+	~MeshBuffer();
+
+	MeshBuffer(const MeshBuffer&) = delete;
+	MeshBuffer& operator=(const MeshBuffer&) = delete;
+
+	/** Waits until the GPU has finished the frame which used the same ring part, releases ranges
+	 * freed in that frame and starts collecting draws.
+	 */
+	void BeginFrame();
+
+	/** Reserves count vertices, growing the buffer when needed. Returns the first vertex. */
+	uint32_t Allocate(uint32_t count);
+	/** The range is reused once the GPU can no longer read it. */
+	void Free(uint32_t first, uint32_t count);
+
+	/** Returns memory for count vertices starting at first, valid until Commit. The range must
+	 * come from Allocate and not be drawn yet.
+	 */
+	ChunkVertex* Map(uint32_t first, uint32_t count);
+	void Commit(uint32_t first, uint32_t count);
+
+	/** Draws count vertices starting at first, moved by origin. */
+	void AddDraw(uint32_t first, uint32_t count, const glm::vec3& origin);
+	/** Issues draws collected since BeginFrame with the texture array bound. Returns the number
+	 * of draw calls.
+	 */
+	size_t Draw(GLuint texture);
+
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Block {
+		uint32_t m_first;
+		uint32_t m_count;
+	};
+
+	// Uklad zgodny z DrawArraysIndirectCommand
+	struct DrawCommand {
+		GLuint m_count;
+		GLuint m_instanceCount;
+		GLuint m_first;
+		GLuint m_baseInstance;
+	};
+
+	void Create();
+	void Grow(size_t vertexCapacity);
+	void SetVertexAttributes();
+	void Release(const Block& block);
+
+	GLuint m_vao{ 0 };
+	GLuint m_vbo{ 0 };
+	GLuint m_commandBuffer{ 0 };
+	GLuint m_originBuffer{ 0 };
+	ChunkVertex* m_vertices{ nullptr };      // zmapowany bufor wierzcholkow, tylko z buffer storage
+	DrawCommand* m_commands{ nullptr };
+	glm::vec3* m_origins{ nullptr };
+
+	size_t m_capacity;
+	size_t m_maxDraws;
+	std::vector<Block> m_freeBlocks;         // posortowane po m_first, sasiednie bloki sa scalane
+	std::array<std::vector<Block>, s_frameCount> m_pendingFrees;
+	std::array<GLsync, s_frameCount> m_fences{};
+	GLsync m_copyFence{ nullptr };           // kopia z Grow, tylko przy zmapowanym buforze
+	uint32_t m_copyEnd{ 0 };                 // [0, m_copyEnd) nadpisze jeszcze kopia
+	size_t m_frame{ 0 };
+
+	std::vector<DrawCommand> m_frameCommands;
+	std::vector<glm::vec3> m_frameOrigins;
+	std::vector<ChunkVertex> m_staging;      // bez buffer storage wierzcholki ida przez glBufferSubData
+	std::chrono::steady_clock::time_point m_uploadStart;
+	Stats m_stats;
+};
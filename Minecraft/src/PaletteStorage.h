@@ -0,0 +1,200 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** Fixed size array of one-byte values compressed with a palette.
+ * Every entry is an index into a small palette of distinct values, packed into 64-bit words
+ * with 1, 2 or 4 bits per entry. An array holding a single value has no packed words at all,
+ * it costs just its palette entry. When there are more distinct values than the palette can
+ * hold, entries are stored directly with 8 bits each.
+ * Set grows the number of bits when a new value does not fit, so edits are transparent.
+ * Capacity of the packed words is kept when the array becomes uniform, so storages which are
+ * refilled over and over (recycled chunks) do not allocate again.
+ */
+template <typename T, size_t Size>
+class PaletteStorage {
+	static_assert(sizeof(T) == 1, "PaletteStorage holds one-byte values only");
+
+public:
+	explicit PaletteStorage(T value = T{}) { Fill(value); }
+
+	T Get(size_t index) const;
+	void Set(size_t index, T value);
+
+	/** Sets every entry to value. Packed words are dropped, but their capacity is kept. */
+	void Fill(T value);
+
+	/** Replaces the content with Size values, using the smallest number of bits that fits. */
+	void Assign(const T* values);
+
+	/** Writes all Size values to the output array. */
+	void Unpack(T* values) const;
+
+	bool IsUniform() const { return m_bits == 0; }
+	T UniformValue() const { return m_palette[0]; }
+
+	size_t BitsPerEntry() const { return m_bits; }
+
+	/** Heap memory held by packed words, including kept capacity, in bytes. */
+	size_t MemoryUsage() const { return m_words.capacity() * sizeof(uint64_t); }
+
+private:
+	static constexpr size_t s_maxPaletteSize = 16;
+	static constexpr size_t s_directBits = 8;
+
+	static constexpr size_t WordCount(size_t bits) { return (Size * bits + 63) / 64; }
+
+	size_t Read(size_t index) const;
+	void Write(size_t index, size_t entry);
+	void Repack(size_t bits);
+
+	std::vector<uint64_t> m_words;
+	std::array<T, s_maxPaletteSize> m_palette{};
+	uint8_t m_paletteSize{ 1 };
+	uint8_t m_bits{ 0 };
+};
+
+template <typename T, size_t Size>
+inline T PaletteStorage<T, Size>::Get(size_t index) const {
+	if (m_bits == 0) {
+		return m_palette[0];
+	}
+
+	const size_t entry = Read(index);
+	return m_bits == s_directBits ? static_cast<T>(entry) : m_palette[entry];
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Set(size_t index, T value) {
+	if (Get(index) == value) {
+		return;
+	}
+
+	if (m_bits != s_directBits) {
+		size_t entry = 0;
+		while (entry < m_paletteSize && m_palette[entry] != value) {
+			++entry;
+		}
+
+		if (entry == m_paletteSize) {
+			// Nowa wartosc - jesli nie miesci sie w palecie, zwiekszamy liczbe bitow
+			if (m_paletteSize == (size_t(1) << m_bits)) {
+				Repack(m_paletteSize == s_maxPaletteSize ? s_directBits : (m_bits == 0 ? 1 : m_bits * 2));
+			}
+			if (m_bits != s_directBits) {
+				m_palette[m_paletteSize++] = value;
+			}
+		}
+
+		if (m_bits != s_directBits) {
+			Write(index, entry);
+			return;
+		}
+	}
+
+	Write(index, static_cast<size_t>(value));
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Fill(T value) {
+	m_palette[0] = value;
+	m_paletteSize = 1;
+	m_bits = 0;
+	m_words.clear();
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Assign(const T* values) {
+	std::array<T, s_maxPaletteSize> palette;
+	size_t paletteSize = 0;
+	bool isDirect = false;
+
+	for (size_t index = 0; index < Size && !isDirect; ++index) {
+		size_t entry = 0;
+		while (entry < paletteSize && palette[entry] != values[index]) {
+			++entry;
+		}
+		if (entry == paletteSize) {
+			if (paletteSize == s_maxPaletteSize) {
+				isDirect = true;
+			}
+			else {
+				palette[paletteSize++] = values[index];
+			}
+		}
+	}
+
+	if (paletteSize == 1) {
+		Fill(palette[0]);
+		return;
+	}
+
+	size_t bits = s_directBits;
+	if (!isDirect) {
+		bits = 1;
+		while ((size_t(1) << bits) < paletteSize) {
+			bits *= 2;
+		}
+	}
+
+	m_palette = palette;
+	m_paletteSize = static_cast<uint8_t>(paletteSize);
+	m_bits = static_cast<uint8_t>(bits);
+	m_words.assign(WordCount(bits), 0);
+
+	for (size_t index = 0; index < Size; ++index) {
+		size_t entry = static_cast<size_t>(values[index]);
+		if (!isDirect) {
+			entry = 0;
+			while (m_palette[entry] != values[index]) {
+				++entry;
+			}
+		}
+		Write(index, entry);
+	}
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Unpack(T* values) const {
+	for (size_t index = 0; index < Size; ++index) {
+		values[index] = Get(index);
+	}
+}
+
+template <typename T, size_t Size>
+inline size_t PaletteStorage<T, Size>::Read(size_t index) const {
+	// 64 jest podzielne przez 1, 2, 4 i 8, wiec wpis nigdy nie przechodzi przez granice slowa
+	const size_t bit = index * m_bits;
+	const uint64_t mask = (uint64_t(1) << m_bits) - 1;
+	return static_cast<size_t>((m_words[bit / 64] >> (bit % 64)) & mask);
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Write(size_t index, size_t entry) {
+	const size_t bit = index * m_bits;
+	const uint64_t mask = (uint64_t(1) << m_bits) - 1;
+	uint64_t& word = m_words[bit / 64];
+	word = (word & ~(mask << (bit % 64))) | ((static_cast<uint64_t>(entry) & mask) << (bit % 64));
+}
+
+template <typename T, size_t Size>
+inline void PaletteStorage<T, Size>::Repack(size_t bits) {
+	std::array<T, Size> values;
+	Unpack(values.data());
+
+	m_words.assign(WordCount(bits), 0);
+	m_bits = static_cast<uint8_t>(bits);
+
+	for (size_t index = 0; index < Size; ++index) {
+		size_t entry = static_cast<size_t>(values[index]);
+		if (bits != s_directBits) {
+			entry = 0;
+			while (m_palette[entry] != values[index]) {
+				++entry;
+			}
+		}
+		Write(index, entry);
+	}
+}
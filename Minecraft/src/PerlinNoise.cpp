@@ -1,7 +1,13 @@
 #include "PerlinNoise.h"
+#include "SplitMix64.h"
 #include <algorithm>
-#include <random>
 #include <numeric>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PERLIN_NOISE_SSE
+#endif
 
 namespace {
 	constexpr std::array<uint8_t, 256> s_permutations = {
@@ -30,6 +36,38 @@ namespace {
 
 		return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
 	}
+
+	/** Gradient used by Grad for given hash, Grad(hash, x, y, z) == dot(GradVector(hash), (x, y, z)). */
+	glm::vec3 GradVector(int hash) {
+		const int h = hash & 15;
+		const int uAxis = h < 8 ? 0 : 1;
+		const int vAxis = h < 4 ? 1 : h == 12 || h == 14 ? 0 : 2;
+
+		glm::vec3 gradient(0.0f);
+		gradient[uAxis] += (h & 1) == 0 ? 1.0f : -1.0f;
+		gradient[vAxis] += (h & 2) == 0 ? 1.0f : -1.0f;
+		return gradient;
+	}
+
+	/** Lattice cell, position inside the cell and its fade, for every sample along one axis. */
+	struct AxisSamples {
+		void Fill(float origin, float step, int count) {
+			m_cells.resize(count);
+			m_fractions.resize(count);
+			m_fades.resize(count);
+			for (int i = 0; i < count; ++i) {
+				const float coord = origin + step * i;
+				const float cell = std::floor(coord);
+				m_cells[i] = static_cast<std::int32_t>(cell) & 255;
+				m_fractions[i] = coord - cell;
+				m_fades[i] = Fade(m_fractions[i]);
+			}
+		}
+
+		std::vector<std::int32_t> m_cells;
+		std::vector<float> m_fractions;
+		std::vector<float> m_fades;
+	};
 }
 
 PerlinNoise::PerlinNoise() {
@@ -37,11 +75,15 @@ PerlinNoise::PerlinNoise() {
 	std::copy(s_permutations.begin(), s_permutations.end(), m_permutations.begin() + 256);
 }
 
-PerlinNoise::PerlinNoise(int seed) {
+PerlinNoise::PerlinNoise(uint64_t seed) {
 	std::iota(m_permutations.begin(), m_permutations.begin() + 256, 0);
-	std::shuffle(m_permutations.begin(), m_permutations.begin() + 256, std::default_random_engine(seed));
-	std::copy(m_permutations.begin(), m_permutations.begin() + 256, m_permutations.begin() + 256);
 
+	// Fisher-Yates z wlasnym generatorem - std::shuffle i silniki z <random> daja rozne wyniki na roznych kompilatorach
+	SplitMix64 random(seed);
+	for (uint32_t i = 255; i > 0; --i) {
+		std::swap(m_permutations[i], m_permutations[random.NextBelow(i + 1)]);
+	}
+	std::copy(m_permutations.begin(), m_permutations.begin() + 256, m_permutations.begin() + 256);
 }
 
 float PerlinNoise::At(const glm::vec3& coords) const {
@@ -90,3 +132,111 @@ float PerlinNoise::At(const glm::vec3& coords) const {
 	const float result = std::lerp(r0, r1, w);
 	return (result * 0.5f) + 0.5f;
 }
+
+void PerlinNoise::Fill(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& count, float* out) const {
+	static thread_local AxisSamples xs, ys, zs;
+	xs.Fill(origin.x, step.x, count.x);
+	ys.Fill(origin.y, step.y, count.y);
+	zs.Fill(origin.z, step.z, count.z);
+
+	// Narozniki komorki w kolejnosci p0..p7 z At
+	const glm::vec3 corners[8] = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+		{ 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+	};
+
+	for (int y = 0; y < count.y; ++y) {
+		const std::int32_t iy = ys.m_cells[y];
+		const float fy = ys.m_fractions[y];
+		const float v = ys.m_fades[y];
+
+		for (int x = 0; x < count.x; ++x) {
+			const std::int32_t ix = xs.m_cells[x];
+			const float fx = xs.m_fractions[x];
+			const float u = xs.m_fades[x];
+
+			const std::uint8_t A = (m_permutations[ix & 255] + iy) & 255;
+			const std::uint8_t B = (m_permutations[(ix + 1) & 255] + iy) & 255;
+
+			float* row = out + (static_cast<size_t>(y) * count.x + x) * count.z;
+
+			// Probki z tej samej komorki wspoldziela hashe i gradienty naroznikow
+			for (int first = 0; first < count.z;) {
+				const std::int32_t iz = zs.m_cells[first];
+				int last = first + 1;
+				while (last < count.z && zs.m_cells[last] == iz) {
+					++last;
+				}
+
+				const std::uint8_t AA = (m_permutations[A] + iz) & 255;
+				const std::uint8_t AB = (m_permutations[(A + 1) & 255] + iz) & 255;
+				const std::uint8_t BA = (m_permutations[B] + iz) & 255;
+				const std::uint8_t BB = (m_permutations[(B + 1) & 255] + iz) & 255;
+				const int hashes[8] = {
+					m_permutations[AA], m_permutations[BA], m_permutations[AB], m_permutations[BB],
+					m_permutations[(AA + 1) & 255], m_permutations[(BA + 1) & 255],
+					m_permutations[(AB + 1) & 255], m_permutations[(BB + 1) & 255]
+				};
+
+				// p_i = g_i . (f - corner_i) = base_i + g_i.z * fz, base_i nie zalezy od z
+				float bases[8];
+				float slopes[8];
+				for (int i = 0; i < 8; ++i) {
+					const glm::vec3 gradient = GradVector(hashes[i]);
+					bases[i] = gradient.x * (fx - corners[i].x) + gradient.y * (fy - corners[i].y)
+						- gradient.z * corners[i].z;
+					slopes[i] = gradient.z;
+				}
+
+				int z = first;
+#if defined(PERLIN_NOISE_SSE)
+				const __m128 uu = _mm_set1_ps(u);
+				const __m128 vv = _mm_set1_ps(v);
+				const __m128 half = _mm_set1_ps(0.5f);
+				for (; z + 4 <= last; z += 4) {
+					const __m128 fz = _mm_loadu_ps(&zs.m_fractions[z]);
+					const __m128 w = _mm_loadu_ps(&zs.m_fades[z]);
+
+					__m128 p[8];
+					for (int i = 0; i < 8; ++i) {
+						p[i] = _mm_add_ps(_mm_set1_ps(bases[i]), _mm_mul_ps(_mm_set1_ps(slopes[i]), fz));
+					}
+
+					const __m128 q0 = _mm_add_ps(p[0], _mm_mul_ps(uu, _mm_sub_ps(p[1], p[0])));
+					const __m128 q1 = _mm_add_ps(p[2], _mm_mul_ps(uu, _mm_sub_ps(p[3], p[2])));
+					const __m128 q2 = _mm_add_ps(p[4], _mm_mul_ps(uu, _mm_sub_ps(p[5], p[4])));
+					const __m128 q3 = _mm_add_ps(p[6], _mm_mul_ps(uu, _mm_sub_ps(p[7], p[6])));
+
+					const __m128 r0 = _mm_add_ps(q0, _mm_mul_ps(vv, _mm_sub_ps(q1, q0)));
+					const __m128 r1 = _mm_add_ps(q2, _mm_mul_ps(vv, _mm_sub_ps(q3, q2)));
+
+					const __m128 result = _mm_add_ps(r0, _mm_mul_ps(w, _mm_sub_ps(r1, r0)));
+					_mm_storeu_ps(row + z, _mm_add_ps(_mm_mul_ps(result, half), half));
+				}
+#endif
+				for (; z < last; ++z) {
+					const float fz = zs.m_fractions[z];
+					const float w = zs.m_fades[z];
+
+					float p[8];
+					for (int i = 0; i < 8; ++i) {
+						p[i] = bases[i] + slopes[i] * fz;
+					}
+
+					const float q0 = p[0] + u * (p[1] - p[0]);
+					const float q1 = p[2] + u * (p[3] - p[2]);
+					const float q2 = p[4] + u * (p[5] - p[4]);
+					const float q3 = p[6] + u * (p[7] - p[6]);
+
+					const float r0 = q0 + v * (q1 - q0);
+					const float r1 = q2 + v * (q3 - q2);
+
+					const float result = r0 + w * (r1 - r0);
+					row[z] = (result * 0.5f) + 0.5f;
+				}
+
+				first = last;
+			}
+		}
+	}
+}
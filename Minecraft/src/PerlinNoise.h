@@ -1,14 +1,25 @@
 #pragma once
 #include <glm/glm.hpp>//Users/jakubstokowski/Desktop/Cube.h
 #include <array>
+#include <cstdint>
 
 class PerlinNoise {
 public:
 	PerlinNoise();
-    PerlinNoise(int seed);
+
+	/** Permutation shuffled with SplitMix64, the same seed gives the same noise on every platform. */
+	explicit PerlinNoise(uint64_t seed);
 
 	float At(const glm::vec3& coords) const;
 
+	/** Samples a regular grid: point (x, y, z) is origin + step * (x, y, z) for x < count.x etc.
+	 * Results are written with z changing fastest, then x, then y - out[(y * count.x + x) * count.z + z].
+	 * Lattice hashes and fade curves are computed once per lattice cell and axis sample and shared
+	 * by all samples using them, samples along z are evaluated 4 at a time with SSE.
+	 * Results match At within 1e-5.
+	 */
+	void Fill(const glm::vec3& origin, const glm::vec3& step, const glm::ivec3& count, float* out) const;
+
 private:
 	std::array<uint8_t, 512> m_permutations;
 };
@@ -0,0 +1,144 @@
+#pragma once
+#include "AABB.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+/** Physical body of the player (or any other entity) moving through the voxel world.
+ * The body is an axis aligned box with its position at the centre of the bottom face.
+ * Step integrates gravity and resolves collisions by sweeping the box separately along
+ * Y, X and Z; each sweep only queries the cells the moving box passes through, so the
+ * cost depends on the distance moved, not on the size of the world.
+ * Step is meant to be called with a fixed time step.
+ */
+class PlayerBody {
+public:
+	static constexpr float s_gravity = 28.0f;			// blocks / s^2
+	static constexpr float s_terminalVelocity = 60.0f;	// blocks / s
+
+	PlayerBody(const glm::vec3& position, const glm::vec3& size)
+		: m_position(position), m_size(size) {}
+
+	const glm::vec3& GetPosition() const { return m_position; }
+	void SetPosition(const glm::vec3& position) { m_position = position; }
+
+	const glm::vec3& GetVelocity() const { return m_velocity; }
+	const glm::vec3& GetSize() const { return m_size; }
+	bool IsOnGround() const { return m_isOnGround; }
+
+	AABB GetAABB() const { return AABB(Min(), Min() + m_size); }
+
+	/** Sets horizontal velocity, vertical velocity is left to gravity. */
+	void SetWalkVelocity(const glm::vec2& velocity) { m_velocity.x = velocity.x; m_velocity.z = velocity.y; }
+	void Stop() { m_velocity = glm::vec3(0.0f); }
+
+	/** Gives the body upward velocity, only if it stands on the ground. */
+	void Jump(float speed);
+
+	/** Advances the body by dt seconds. isSolid(const glm::ivec3& block) tells whether the block
+	 * with given world coordinates blocks movement.
+	 */
+	template <typename IsSolid>
+	void Step(float dt, const IsSolid& isSolid);
+
+private:
+	static constexpr float s_epsilon = 0.001f;
+
+	glm::vec3 Min() const { return glm::vec3(m_position.x - m_size.x * 0.5f, m_position.y, m_position.z - m_size.z * 0.5f); }
+
+	/** Moves the body along one axis by at most delta, stopping at the first solid cell. Returns the distance moved. */
+	template <typename IsSolid>
+	float Sweep(int axis, float delta, const IsSolid& isSolid);
+
+	glm::vec3 m_position;
+	glm::vec3 m_size;
+	glm::vec3 m_velocity{ 0.0f };
+	bool m_isOnGround{ false };
+};
+
+inline void PlayerBody::Jump(float speed) {
+	if (m_isOnGround) {
+		m_velocity.y = speed;
+		m_isOnGround = false;
+	}
+}
+
+template <typename IsSolid>
+inline void PlayerBody::Step(float dt, const IsSolid& isSolid) {
+	m_velocity.y = std::max(m_velocity.y - s_gravity * dt, -s_terminalVelocity);
+
+	const glm::vec3 delta = m_velocity * dt;
+	m_isOnGround = false;
+
+	// Najpierw os pionowa, zeby chodzenie po ziemi nie zaczepialo o jej krawedzie
+	const int axes[] = { 1, 0, 2 };
+	for (int axis : axes) {
+		const float moved = Sweep(axis, delta[axis], isSolid);
+		m_position[axis] += moved;
+
+		if (moved != delta[axis]) {
+			if (axis == 1 && delta[axis] < 0.0f) {
+				m_isOnGround = true;
+			}
+			m_velocity[axis] = 0.0f;
+		}
+	}
+}
+
+template <typename IsSolid>
+inline float PlayerBody::Sweep(int axis, float delta, const IsSolid& isSolid) {
+	if (delta == 0.0f) {
+		return 0.0f;
+	}
+
+	const glm::vec3 min = Min();
+	const glm::vec3 max = min + m_size;
+
+	// Komorki, ktore pudelko zajmuje na pozostalych osiach
+	const int uAxis = (axis + 1) % 3;
+	const int vAxis = (axis + 2) % 3;
+	const int uFirst = static_cast<int>(std::floor(min[uAxis] + s_epsilon));
+	const int uLast = static_cast<int>(std::floor(max[uAxis] - s_epsilon));
+	const int vFirst = static_cast<int>(std::floor(min[vAxis] + s_epsilon));
+	const int vLast = static_cast<int>(std::floor(max[vAxis] - s_epsilon));
+
+	const auto isLayerSolid = [&](int layer) {
+		glm::ivec3 cell;
+		cell[axis] = layer;
+		for (int u = uFirst; u <= uLast; ++u) {
+			cell[uAxis] = u;
+			for (int v = vFirst; v <= vLast; ++v) {
+				cell[vAxis] = v;
+				if (isSolid(cell)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	};
+
+	// Przechodzimy warstwy komorek od sciany prowadzacej; komorki juz zajmowane przez pudelko pomijamy
+	if (delta > 0.0f) {
+		const float lead = max[axis];
+		const int first = static_cast<int>(std::floor(lead - s_epsilon)) + 1;
+		const int last = static_cast<int>(std::ceil(lead + delta)) - 1;
+		for (int layer = first; layer <= last; ++layer) {
+			if (isLayerSolid(layer)) {
+				return std::max(0.0f, static_cast<float>(layer) - lead);
+			}
+		}
+	}
+	else {
+		const float lead = min[axis];
+		const int first = static_cast<int>(std::floor(lead + s_epsilon)) - 1;
+		const int last = static_cast<int>(std::floor(lead + delta));
+		for (int layer = first; layer >= last; --layer) {
+			if (isLayerSolid(layer)) {
+				return std::min(0.0f, static_cast<float>(layer + 1) - lead);
+			}
+		}
+	}
+	return delta;
+}
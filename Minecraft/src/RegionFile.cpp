@@ -0,0 +1,167 @@
+#include "RegionFile.h"
+#include "FileSync.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace {
+	uint32_t ReadUint32(const uint8_t* bytes) {
+		return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8
+			| static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+	}
+
+	void WriteUint32(uint32_t value, uint8_t* bytes) {
+		for (int i = 0; i < 4; ++i) {
+			bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+		}
+	}
+
+	int FloorDiv(int value, int divisor) {
+		return value >= 0 ? value / divisor : (value + 1) / divisor - 1;
+	}
+}
+
+RegionFile::RegionFile(const std::filesystem::path& path)
+	: m_path(path) {
+	std::vector<uint8_t> header(static_cast<size_t>(s_headerSectors) * s_sectorSize, 0);
+
+	std::error_code error;
+	if (std::filesystem::exists(m_path, error)) {
+		std::ifstream file(m_path, std::ios::binary);
+		file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		if (file.gcount() != static_cast<std::streamsize>(header.size())) {
+			return;
+		}
+
+		const uintmax_t fileSize = std::filesystem::file_size(m_path, error);
+		m_sectorCount = std::max(s_headerSectors, static_cast<uint32_t>((fileSize + s_sectorSize - 1) / s_sectorSize));
+		m_isSectorUsed.assign(m_sectorCount, false);
+		std::fill(m_isSectorUsed.begin(), m_isSectorUsed.begin() + s_headerSectors, true);
+		for (size_t index = 0; index < s_chunkCount; ++index) {
+			Entry entry;
+			entry.m_sector = ReadUint32(&header[index * s_entrySize]);
+			entry.m_size = ReadUint32(&header[index * s_entrySize + 4]);
+			entry.m_checksum = ReadUint32(&header[index * s_entrySize + 8]);
+			if (entry.m_size == 0) {
+				continue;
+			}
+
+			// Wpis wskazujacy poza plik albo na zajete sektory jest uszkodzony - chunk traktujemy jak niezapisany
+			const uint32_t sectors = SectorsFor(entry.m_size);
+			if (entry.m_sector < s_headerSectors || entry.m_sector >= m_sectorCount || sectors > m_sectorCount - entry.m_sector
+				|| std::find(m_isSectorUsed.begin() + entry.m_sector, m_isSectorUsed.begin() + entry.m_sector + sectors, true)
+					!= m_isSectorUsed.begin() + entry.m_sector + sectors) {
+				continue;
+			}
+			m_entries[index] = entry;
+			MarkSectors(entry, true);
+		}
+	}
+	else {
+		std::ofstream file(m_path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		if (!file) {
+			return;
+		}
+		m_isSectorUsed.assign(s_headerSectors, true);
+	}
+
+	m_isValid = true;
+	Remap();
+}
+
+glm::ivec2 RegionFile::RegionOf(const glm::ivec2& chunkPos) {
+	return glm::ivec2(FloorDiv(chunkPos.x, s_size), FloorDiv(chunkPos.y, s_size));
+}
+
+size_t RegionFile::IndexOf(const glm::ivec2& chunkPos) {
+	const glm::ivec2 local = chunkPos - RegionOf(chunkPos) * s_size;
+	return static_cast<size_t>(local.y) * s_size + local.x;
+}
+
+bool RegionFile::Write(size_t index, const uint8_t* data, size_t size) {
+	if (!m_isValid || size == 0) {
+		return false;
+	}
+	m_mapping.Close();
+
+	// Nowa wersja zawsze trafia do wolnych sektorow, stara zostaje nietknieta do przelaczenia wpisu
+	const uint32_t sectors = SectorsFor(size);
+	Entry entry;
+	entry.m_sector = FindFreeSectors(sectors);
+	entry.m_size = static_cast<uint32_t>(size);
+	entry.m_checksum = Checksum(data, size);
+
+	std::FILE* file = std::fopen(m_path.string().c_str(), "r+b");
+	if (!file) {
+		return false;
+	}
+
+	// Najpierw dane, potem wpis w tablicy. Wpis zajmuje 16 bajtow i nie przecina sektora dysku, wiec
+	// po awarii tablica wskazuje stara albo nowa wersje w calosci, a suma kontrolna wykrywa reszte.
+	// Po zapisie czekamy na dysk, bo dopiero wtedy mozna usunac edycje chunka z dziennika
+	static const std::array<uint8_t, s_sectorSize> padding{};
+	uint8_t bytes[s_entrySize]{};
+	WriteUint32(entry.m_sector, bytes);
+	WriteUint32(entry.m_size, bytes + 4);
+	WriteUint32(entry.m_checksum, bytes + 8);
+
+	const size_t paddingSize = static_cast<size_t>(sectors) * s_sectorSize - size;
+	bool isWritten = SeekFile(file, static_cast<uint64_t>(entry.m_sector) * s_sectorSize)
+		&& std::fwrite(data, 1, size, file) == size
+		&& std::fwrite(padding.data(), 1, paddingSize, file) == paddingSize
+		&& SyncFile(file)
+		&& SeekFile(file, static_cast<uint64_t>(index) * s_entrySize)
+		&& std::fwrite(bytes, 1, s_entrySize, file) == s_entrySize
+		&& SyncFile(file);
+	isWritten = std::fclose(file) == 0 && isWritten;
+	if (!isWritten) {
+		return false;
+	}
+
+	// Tablica na dysku wskazuje juz nowe sektory, wiec stare mozna oddac kolejnym zapisom
+	if (m_entries[index].m_size != 0) {
+		MarkSectors(m_entries[index], false);
+	}
+	m_entries[index] = entry;
+	m_sectorCount = std::max(m_sectorCount, entry.m_sector + sectors);
+	MarkSectors(entry, true);
+	return true;
+}
+
+uint32_t RegionFile::Checksum(const uint8_t* data, size_t size) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+uint32_t RegionFile::FindFreeSectors(uint32_t count) const {
+	uint32_t run = 0;
+	for (uint32_t sector = s_headerSectors; sector < m_sectorCount; ++sector) {
+		run = m_isSectorUsed[sector] ? 0 : run + 1;
+		if (run == count) {
+			return sector + 1 - count;
+		}
+	}
+	// Wolny ogon pliku mozna przedluzyc
+	return m_sectorCount - run;
+}
+
+void RegionFile::MarkSectors(const Entry& entry, bool isUsed) {
+	const uint32_t last = entry.m_sector + SectorsFor(entry.m_size);
+	if (m_isSectorUsed.size() < last) {
+		m_isSectorUsed.resize(last, false);
+	}
+	std::fill(m_isSectorUsed.begin() + entry.m_sector, m_isSectorUsed.begin() + last, isUsed);
+}
+
+void RegionFile::Remap() {
+	if (m_isValid) {
+		m_mapping.Open(m_path);
+	}
+}
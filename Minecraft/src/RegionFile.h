@@ -0,0 +1,90 @@
+#pragma once
+#include "MappedFile.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/** File holding serialized chunks of a 32 x 32 chunk region.
+ * The file starts with a table of s_chunkCount entries (first sector, size in bytes, FNV-1a
+ * checksum of the data, reserved; all little endian uint32), chunk data follows in 4 KiB sectors.
+ * A chunk is never overwritten in place: it goes to free sectors (freed by earlier writes or at
+ * the end of the file) and its table entry is switched only after the data is on the disk, so an
+ * interrupted write leaves the previous version intact. Entries never cross a disk sector.
+ * A chunk whose data does not match its checksum is treated as not stored.
+ * Reads go through a memory mapping of the whole file. Writes use ordinary file I/O, so
+ * Write closes the mapping and Remap has to be called after a batch of writes.
+ * The class does no locking, readers and the writer have to be synchronized by the owner.
+ */
+class RegionFile {
+public:
+	static constexpr int s_size = 32;	// chunks along X and Z
+	static constexpr size_t s_chunkCount = static_cast<size_t>(s_size) * s_size;
+	static constexpr size_t s_sectorSize = 4096;
+
+	/** Opens the region file, creating an empty one if it does not exist. */
+	explicit RegionFile(const std::filesystem::path& path);
+
+	/** Region containing given chunk and index of the chunk inside it. */
+	static glm::ivec2 RegionOf(const glm::ivec2& chunkPos);
+	static size_t IndexOf(const glm::ivec2& chunkPos);
+
+	/** Calls read(const uint8_t* data, size_t size) with the stored chunk, directly from the mapping.
+	 * Returns false if the chunk is not stored or is damaged, otherwise the result of read.
+	 */
+	template <typename Reader>
+	bool Read(size_t index, Reader&& read) const;
+
+	bool Contains(size_t index) const { return m_entries[index].m_size != 0; }
+
+	/** Stores the chunk, size must be greater than 0. Returns false on I/O error. */
+	bool Write(size_t index, const uint8_t* data, size_t size);
+
+	/** Maps the file again after writes. */
+	void Remap();
+
+	bool IsValid() const { return m_isValid; }
+
+private:
+	struct Entry {
+		uint32_t m_sector{ 0 };
+		uint32_t m_size{ 0 };
+		uint32_t m_checksum{ 0 };
+	};
+
+	static constexpr size_t s_entrySize = 16;
+	static constexpr uint32_t s_headerSectors = static_cast<uint32_t>(
+		(s_chunkCount * s_entrySize + s_sectorSize - 1) / s_sectorSize);
+
+	static uint32_t SectorsFor(size_t size) { return static_cast<uint32_t>((size + s_sectorSize - 1) / s_sectorSize); }
+	static uint32_t Checksum(const uint8_t* data, size_t size);
+
+	/** First sector of count free sectors in a row, m_sectorCount if there are none. */
+	uint32_t FindFreeSectors(uint32_t count) const;
+	void MarkSectors(const Entry& entry, bool isUsed);
+
+	std::filesystem::path m_path;
+	std::array<Entry, s_chunkCount> m_entries;
+	uint32_t m_sectorCount{ s_headerSectors };
+	std::vector<bool> m_isSectorUsed;	// indeksowane sektorem, naglowek jest zawsze zajety
+	MappedFile m_mapping;
+	bool m_isValid{ false };
+};
+
+template <typename Reader>
+inline bool RegionFile::Read(size_t index, Reader&& read) const {
+	const Entry& entry = m_entries[index];
+	if (entry.m_size == 0 || !m_mapping.IsOpen()) {
+		return false;
+	}
+
+	const size_t offset = static_cast<size_t>(entry.m_sector) * s_sectorSize;
+	if (offset + entry.m_size > m_mapping.Size() || Checksum(m_mapping.Data() + offset, entry.m_size) != entry.m_checksum) {
+		return false;
+	}
+	return read(m_mapping.Data() + offset, static_cast<size_t>(entry.m_size));
+}
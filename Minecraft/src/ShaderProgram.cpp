@@ -1,4 +1,5 @@
 #include "ShaderProgram.h"
+#include "GLHelpers.h"
 #include <iostream>
 #include <assert.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -9,33 +10,53 @@ std::string ShaderProgram::s_fragmentShaderSource = R"(
     out vec4 FragColor;
 
     in vec2 TexCoord;
+    flat in vec2 TileOrigin;
+    flat in float Layer;
 
-    uniform sampler2D texture1;
+    // Warstwa tablicy na kazdy typ kostki (CubePalette)
+    uniform sampler2DArray texture1;
+
+    const vec2 tileSize = vec2(0.25, 1.0 / 3.0);
 
     void main() {
-        FragColor = texture(texture1, TexCoord);
+        // TexCoord jest w blokach, fract() powtarza kafelek sciany na polaczonych scianach
+        vec2 uv = TileOrigin + fract(TexCoord) * tileSize;
+        FragColor = textureGrad(texture1, vec3(uv, Layer), dFdx(TexCoord) * tileSize, dFdy(TexCoord) * tileSize);
     })";
 
 std::string ShaderProgram::s_vertexShaderSource = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
     layout (location = 1) in vec2 aTexCoord;
+    layout (location = 2) in float aFace;
+    // Polozenie chunka, jedna wartosc na instancje
+    layout (location = 3) in vec3 aOffset;
+    layout (location = 4) in float aLayer;
 
     out vec2 TexCoord;
+    flat out vec2 TileOrigin;
+    flat out float Layer;
 
-    uniform mat4 model;
     uniform mat4 view;
     uniform mat4 projection;
 
+    // Lewy dolny rog kafelka kazdej sciany (Cube::Face) w teksturze, jak w Cube::s_vertices
+    const vec2 faceTiles[6] = vec2[6](
+        vec2(0.25, 0.0),
+        vec2(0.25, 2.0 / 3.0),
+        vec2(0.5, 1.0 / 3.0),
+        vec2(0.0, 1.0 / 3.0),
+        vec2(0.75, 1.0 / 3.0),
+        vec2(0.25, 1.0 / 3.0));
+
     void main() {
-        gl_Position = projection * view * model *vec4(aPos, 1.0);
+        gl_Position = projection * view * vec4(aPos + aOffset, 1.0);
         TexCoord = aTexCoord;
+        TileOrigin = faceTiles[int(aFace)];
+        Layer = aLayer;
     })";
 
 
-extern GLuint CreateShader(const GLchar* shaderSource, GLenum shaderType); // Deklaracja funkcji, eby mona byo jej uy
-extern GLuint CreateTexture(const std::string& path); // Deklaracja funkcji, eby mona byo jej uy
-extern GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader, GLuint geometryShader = 0);
 
 ShaderProgram::ShaderProgram(const std::string& vertexSource, const std::string& fragmentSource) {
     GLuint vertexShader = CreateShader(s_vertexShaderSource.c_str(), GL_VERTEX_SHADER);
@@ -0,0 +1,98 @@
+#pragma once
+#include "PlayerBody.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+/** Game simulation advanced in fixed ticks, independently of the render frame rate.
+ * Advance accumulates frame time and runs as many whole ticks as fit, the remainder is
+ * carried to the next frame. Rendering uses the player position interpolated between the
+ * last two ticks, so movement stays smooth when the frame rate and tick rate differ.
+ * World is the chunk manager: it needs Update(const glm::vec3&) and IsSolid(const glm::ivec3&).
+ * Nothing here touches the window or GL, so the simulation can also run headless.
+ */
+template <typename World>
+class Simulation {
+public:
+	struct Input {
+		glm::vec2 m_walk{ 0.0f };	// horizontal velocity, X is world X and Y is world Z
+		bool m_isJumping{ false };
+	};
+
+	static constexpr float s_jumpSpeed = 8.5f;
+
+	Simulation(World& world, const PlayerBody& player, float tickTime)
+		: m_world(world), m_player(player), m_previousPosition(player.GetPosition()), m_tickTime(tickTime) {}
+
+	/** Runs whole ticks for frameTime seconds of real time and returns how many were run.
+	 * Frame time is clamped, so a long stall does not cause a burst of catch-up ticks.
+	 */
+	size_t Advance(float frameTime, const Input& input);
+
+	/** Runs exactly one tick. */
+	void Tick(const Input& input);
+
+	/** Moves the player without simulating, e.g. while flying. */
+	void Teleport(const glm::vec3& position);
+
+	/** Player position between the last two ticks, for rendering. */
+	glm::vec3 InterpolatedPosition() const;
+
+	const PlayerBody& GetPlayer() const { return m_player; }
+	float GetTickTime() const { return m_tickTime; }
+	size_t GetTickCount() const { return m_tickCount; }
+
+private:
+	static constexpr float s_maxFrameTime = 0.25f;
+
+	World& m_world;
+	PlayerBody m_player;
+	glm::vec3 m_previousPosition;
+	float m_tickTime;
+	float m_accumulator{ 0.0f };
+	size_t m_tickCount{ 0 };
+};
+
+template <typename World>
+inline size_t Simulation<World>::Advance(float frameTime, const Input& input) {
+	m_accumulator += std::min(frameTime, s_maxFrameTime);
+
+	size_t ticks = 0;
+	while (m_accumulator >= m_tickTime) {
+		Tick(input);
+		m_accumulator -= m_tickTime;
+		++ticks;
+	}
+	return ticks;
+}
+
+template <typename World>
+inline void Simulation<World>::Tick(const Input& input) {
+	m_previousPosition = m_player.GetPosition();
+
+	m_player.SetWalkVelocity(input.m_walk);
+	if (input.m_isJumping) {
+		m_player.Jump(s_jumpSpeed);
+	}
+	m_player.Step(m_tickTime, [this](const glm::ivec3& block) { return m_world.IsSolid(block); });
+
+	m_world.Update(m_player.GetPosition());
+	++m_tickCount;
+}
+
+template <typename World>
+inline void Simulation<World>::Teleport(const glm::vec3& position) {
+	m_player.SetPosition(position);
+	m_player.Stop();
+	m_previousPosition = position;
+	m_accumulator = 0.0f;
+	m_world.Update(position);
+}
+
+template <typename World>
+inline glm::vec3 Simulation<World>::InterpolatedPosition() const {
+	const float alpha = m_accumulator / m_tickTime;
+	return m_previousPosition + (m_player.GetPosition() - m_previousPosition) * alpha;
+}
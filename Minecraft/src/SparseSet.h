@@ -0,0 +1,70 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/** Set of indices from range [0, Capacity) with O(1) insert, erase and lookup.
+ * Indices are kept densely packed, so iterating the set touches only its elements.
+ * Erase moves the last element into the freed slot, so the order of elements is not preserved.
+ * Storage has fixed size and lives inside the set, it never allocates.
+ */
+template <size_t Capacity>
+class SparseSet {
+public:
+	using index_t = std::conditional_t<(Capacity <= 0xFFFF), uint16_t, uint32_t>;
+	using const_iterator = const index_t*;
+
+	SparseSet() { m_slots.fill(s_npos); }
+
+	bool Insert(size_t index);
+	bool Erase(size_t index);
+	bool Contains(size_t index) const { return m_slots[index] != s_npos; }
+	void Clear();
+
+	size_t Size() const { return m_size; }
+	bool Empty() const { return m_size == 0; }
+
+	const_iterator begin() const { return m_dense.data(); }
+	const_iterator end() const { return m_dense.data() + m_size; }
+
+private:
+	static constexpr index_t s_npos = static_cast<index_t>(~index_t(0));
+
+	std::array<index_t, Capacity> m_dense;
+	std::array<index_t, Capacity> m_slots;
+	size_t m_size{ 0 };
+};
+
+template <size_t Capacity>
+inline bool SparseSet<Capacity>::Insert(size_t index) {
+	if (Contains(index)) {
+		return false;
+	}
+
+	m_slots[index] = static_cast<index_t>(m_size);
+	m_dense[m_size++] = static_cast<index_t>(index);
+	return true;
+}
+
+template <size_t Capacity>
+inline bool SparseSet<Capacity>::Erase(size_t index) {
+	if (!Contains(index)) {
+		return false;
+	}
+
+	const index_t slot = m_slots[index];
+	const index_t last = m_dense[--m_size];
+	m_dense[slot] = last;
+	m_slots[last] = slot;
+	m_slots[index] = s_npos;
+	return true;
+}
+
+template <size_t Capacity>
+inline void SparseSet<Capacity>::Clear() {
+	for (index_t index : *this) {
+		m_slots[index] = s_npos;
+	}
+	m_size = 0;
+}
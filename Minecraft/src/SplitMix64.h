@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+/** SplitMix64 pseudo random generator.
+ * Standard library engines such as std::default_random_engine and all of the distributions
+ * are implementation defined, so the same seed gives different numbers with MSVC and libstdc++.
+ * This generator and NextBelow are fully specified, anything seeded with it (world generation)
+ * is identical on every platform and compiler.
+ */
+class SplitMix64 {
+public:
+	explicit SplitMix64(uint64_t seed) : m_state(seed) {}
+
+	uint64_t Next() {
+		uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	/** Uniform number in [0, bound), bound > 0. Multiply and shift with rejection (Lemire), so there is no modulo bias. */
+	uint32_t NextBelow(uint32_t bound) {
+		uint64_t product = (Next() >> 32) * bound;
+		uint32_t low = static_cast<uint32_t>(product);
+		if (low < bound) {
+			const uint32_t threshold = (0u - bound) % bound;
+			while (low < threshold) {
+				product = (Next() >> 32) * bound;
+				low = static_cast<uint32_t>(product);
+			}
+		}
+		return static_cast<uint32_t>(product >> 32);
+	}
+
+private:
+	uint64_t m_state;
+};
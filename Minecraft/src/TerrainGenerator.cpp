@@ -0,0 +1,210 @@
+#include "TerrainGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	uint64_t ElapsedNanoseconds(Clock::time_point& start) {
+		const Clock::time_point now = Clock::now();
+		const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+		start = now;
+		return elapsed;
+	}
+
+	/** Noise sampled on the coarse lattice, interpolated to block resolution one row along z at a time. */
+	struct Lattice {
+		void Resize(const glm::ivec3& count) {
+			m_count = count;
+			m_values.resize(static_cast<size_t>(count.x) * count.y * count.z);
+			m_row.resize(count.z);
+		}
+
+		/** Bilinear interpolation in x and y for every lattice z, the result is in m_row. */
+		void PrepareRow(int cellX, float tx, int cellY, float ty) {
+			const float* v00 = &m_values[(static_cast<size_t>(cellY) * m_count.x + cellX) * m_count.z];
+			const float* v01 = v00 + m_count.z;
+			const float* v10 = v00 + static_cast<size_t>(m_count.x) * m_count.z;
+			const float* v11 = v10 + m_count.z;
+			for (int z = 0; z < m_count.z; ++z) {
+				const float bottom = v00[z] + tx * (v01[z] - v00[z]);
+				const float top = v10[z] + tx * (v11[z] - v10[z]);
+				m_row[z] = bottom + ty * (top - bottom);
+			}
+		}
+
+		float At(int cellZ, float tz) const {
+			return m_row[cellZ] + tz * (m_row[cellZ + 1] - m_row[cellZ]);
+		}
+
+		glm::ivec3 m_count{ 0 };
+		std::vector<float> m_values;
+		std::vector<float> m_row;
+	};
+}
+
+TerrainGenerator::TerrainGenerator(const PerlinNoise& noise)
+	: TerrainGenerator(noise, Settings()) {}
+
+TerrainGenerator::TerrainGenerator(const PerlinNoise& noise, const Settings& settings)
+	: m_noise(noise), m_settings(settings) {}
+
+void TerrainGenerator::FillFractal(const Fractal& fractal, const glm::vec3& origin, const glm::vec3& step,
+	const glm::ivec3& count, float* out, float* scratch) const {
+	const size_t size = static_cast<size_t>(count.x) * count.y * count.z;
+	std::fill(out, out + size, 0.0f);
+
+	float frequency = fractal.m_frequency;
+	float amplitude = 1.0f;
+	float amplitudeSum = 0.0f;
+	for (int octave = 0; octave < fractal.m_octaves; ++octave) {
+		// Przesuniecie kazdej oktawy, zeby wszystkie nie mialy zera w tym samym punkcie siatki
+		const glm::vec3 offset(octave * 31.7f, octave * 17.3f, octave * 23.9f);
+		m_noise.Fill(origin * frequency + offset, step * frequency, count, scratch);
+
+		if (fractal.m_isRidged) {
+			for (size_t index = 0; index < size; ++index) {
+				const float ridge = 1.0f - std::abs(scratch[index] * 2.0f - 1.0f);
+				out[index] += amplitude * ridge * ridge;
+			}
+		}
+		else {
+			for (size_t index = 0; index < size; ++index) {
+				out[index] += amplitude * (scratch[index] * 2.0f - 1.0f);
+			}
+		}
+
+		amplitudeSum += amplitude;
+		frequency *= fractal.m_lacunarity;
+		amplitude *= fractal.m_gain;
+	}
+
+	if (amplitudeSum > 0.0f) {
+		const float normalization = 1.0f / amplitudeSum;
+		for (size_t index = 0; index < size; ++index) {
+			out[index] *= normalization;
+		}
+	}
+}
+
+int TerrainGenerator::Generate(const glm::ivec3& origin, const glm::ivec3& size, Cube::Type* types) const {
+	static thread_local std::vector<float> heights;
+	static thread_local std::vector<float> scratch;
+	static thread_local Lattice density, caves;
+
+	Clock::time_point start = Clock::now();
+
+	// Wysokosc powierzchni w kazdej kolumnie, w blokach
+	heights.resize(static_cast<size_t>(size.x) * size.z);
+	scratch.resize(heights.size());
+	FillFractal(m_settings.m_height, glm::vec3(origin.x, 0.0f, origin.z), glm::vec3(1.0f, 0.0f, 1.0f),
+		glm::ivec3(size.x, 1, size.z), heights.data(), scratch.data());
+
+	float lowest = static_cast<float>(size.y);
+	float highest = 0.0f;
+	for (float& height : heights) {
+		height = m_settings.m_baseHeight + m_settings.m_heightAmplitude * height;
+		lowest = std::min(lowest, height);
+		highest = std::max(highest, height);
+	}
+	const int top = std::clamp(static_cast<int>(std::ceil(highest + m_settings.m_overhang)) + 1, 1, size.y);
+	AddTime(Stage::Height, ElapsedNanoseconds(start));
+
+	// Gestosc 3D zmienia wynik tylko w pasie +-overhang wokol powierzchni, nizej zawsze jest skala
+	const int bandBottom = std::clamp(static_cast<int>(std::floor(lowest - m_settings.m_overhang)), 0, top - 1);
+	const int bandFirstCell = bandBottom / s_latticeSpacing;
+	const int lastCell = (top - 1) / s_latticeSpacing;
+	const int cellsX = (size.x - 1) / s_latticeSpacing + 2;
+	const int cellsZ = (size.z - 1) / s_latticeSpacing + 2;
+	const glm::vec3 latticeStep(static_cast<float>(s_latticeSpacing));
+
+	density.Resize(glm::ivec3(cellsX, lastCell - bandFirstCell + 2, cellsZ));
+	caves.Resize(glm::ivec3(cellsX, lastCell + 2, cellsZ));
+	scratch.resize(caves.m_values.size());
+
+	FillFractal(m_settings.m_density, glm::vec3(origin.x, bandFirstCell * s_latticeSpacing, origin.z), latticeStep,
+		density.m_count, density.m_values.data(), scratch.data());
+	AddTime(Stage::Density, ElapsedNanoseconds(start));
+
+	FillFractal(m_settings.m_caves, glm::vec3(origin), latticeStep, caves.m_count, caves.m_values.data(), scratch.data());
+	AddTime(Stage::Caves, ElapsedNanoseconds(start));
+
+	const float fraction = 1.0f / s_latticeSpacing;
+	const size_t layerSize = static_cast<size_t>(size.x) * size.z;
+	size_t index = 0;
+	for (int y = 0; y < top; ++y) {
+		const int cellY = y / s_latticeSpacing;
+		const float ty = (y % s_latticeSpacing) * fraction;
+		const bool isInBand = y >= bandBottom;
+
+		for (int x = 0; x < size.x; ++x) {
+			const int cellX = x / s_latticeSpacing;
+			const float tx = (x % s_latticeSpacing) * fraction;
+			if (isInBand) {
+				density.PrepareRow(cellX, tx, cellY - bandFirstCell, ty);
+			}
+			caves.PrepareRow(cellX, tx, cellY, ty);
+
+			for (int z = 0; z < size.z; ++z, ++index) {
+				const int cellZ = z / s_latticeSpacing;
+				const float tz = (z % s_latticeSpacing) * fraction;
+
+				// Gestosc > 0 to skala; szum 3D przesuwa powierzchnie, tworzac nawisy
+				float solidity = heights[static_cast<size_t>(x) * size.z + z] - y;
+				if (isInBand) {
+					solidity += m_settings.m_overhang * density.At(cellZ, tz);
+				}
+				const bool isSolid = y == 0
+					|| (solidity > 0.0f && caves.At(cellZ, tz) <= m_settings.m_caveThreshold);
+
+				types[index] = isSolid ? Cube::Type::Stone : Cube::Type::None;
+			}
+		}
+	}
+
+	// Blok z powietrzem nad soba staje sie trawa; wyzsza warstwa nie jest jeszcze zmieniona
+	for (size_t block = 0; block < index; ++block) {
+		if (types[block] == Cube::Type::Stone
+			&& (block + layerSize >= index || types[block + layerSize] == Cube::Type::None)) {
+			types[block] = Cube::Type::GrassDebug;
+		}
+	}
+	std::fill(types + index, types + layerSize * size.y, Cube::Type::None);
+	AddTime(Stage::Blocks, ElapsedNanoseconds(start));
+
+	m_columns.fetch_add(1, std::memory_order_relaxed);
+	return top;
+}
+
+TerrainGenerator::Timings TerrainGenerator::GetTimings() const {
+	Timings timings;
+	for (size_t stage = 0; stage < s_stageCount; ++stage) {
+		timings.m_nanoseconds[stage] = m_nanoseconds[stage].load(std::memory_order_relaxed);
+	}
+	timings.m_columns = m_columns.load(std::memory_order_relaxed);
+	return timings;
+}
+
+void TerrainGenerator::ResetTimings() {
+	for (std::atomic<uint64_t>& nanoseconds : m_nanoseconds) {
+		nanoseconds.store(0, std::memory_order_relaxed);
+	}
+	m_columns.store(0, std::memory_order_relaxed);
+}
+
+const char* TerrainGenerator::StageName(Stage stage) {
+	switch (stage) {
+	case Stage::Height: return "height";
+	case Stage::Density: return "density";
+	case Stage::Caves: return "caves";
+	case Stage::Blocks: return "blocks";
+	}
+	return "?";
+}
+
+void TerrainGenerator::AddTime(Stage stage, uint64_t nanoseconds) const {
+	m_nanoseconds[static_cast<size_t>(stage)].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
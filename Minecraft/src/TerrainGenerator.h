@@ -0,0 +1,81 @@
+#pragma once
+#include "Cube.h"
+#include "PerlinNoise.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/** Generates block types of a chunk column from layered Perlin noise.
+ * The surface comes from a 2D fractal heightmap, a 3D density term on top of it bends
+ * the surface into overhangs, and ridged 3D noise carves caves below it.
+ * 3D noise is only evaluated on a coarse lattice (every s_latticeSpacing blocks) and
+ * trilinearly interpolated to block resolution; the lattice values are kept in thread local
+ * buffers, so each worker evaluates every lattice point once per chunk without allocating.
+ * Generate can be called from many threads at once, time spent in every stage is summed
+ * over all calls and can be read with GetTimings.
+ */
+class TerrainGenerator {
+public:
+	/** Sum of octaves of noise, each with frequency multiplied by lacunarity and amplitude by gain.
+	 * fBm sums the noise itself and is in [-1, 1], ridged sums (1 - |noise|)^2 and is in [0, 1].
+	 */
+	struct Fractal {
+		int m_octaves{ 4 };
+		float m_frequency{ 0.02f };	// 1 / blocks
+		float m_lacunarity{ 2.0f };
+		float m_gain{ 0.5f };
+		bool m_isRidged{ false };
+	};
+
+	struct Settings {
+		Fractal m_height{ 4, 0.012f, 2.0f, 0.5f, false };
+		Fractal m_density{ 3, 0.04f, 2.0f, 0.5f, false };
+		Fractal m_caves{ 2, 0.05f, 2.0f, 0.5f, true };
+		float m_baseHeight{ 30.0f };		// blocks
+		float m_heightAmplitude{ 18.0f };	// blocks
+		float m_overhang{ 5.0f };			// how many blocks the 3D density can move the surface by
+		float m_caveThreshold{ 0.82f };		// ridged cave noise above this is air
+	};
+
+	enum class Stage : uint8_t { Height, Density, Caves, Blocks };
+	static constexpr size_t s_stageCount = 4;
+
+	struct Timings {
+		std::array<uint64_t, s_stageCount> m_nanoseconds{};
+		uint64_t m_columns{ 0 };
+	};
+
+	static constexpr int s_latticeSpacing = 4;
+
+	explicit TerrainGenerator(const PerlinNoise& noise);
+	TerrainGenerator(const PerlinNoise& noise, const Settings& settings);
+
+	/** Fills size.x * size.y * size.z block types of the column with its minimal corner at origin
+	 * (world blocks), z changing fastest, then x, then y - types[(y * size.x + x) * size.z + z].
+	 * Returns the number of bottom layers which may contain blocks, all layers above are None.
+	 */
+	int Generate(const glm::ivec3& origin, const glm::ivec3& size, Cube::Type* types) const;
+
+	/** Evaluates the fractal on a regular grid, same layout as PerlinNoise::Fill. scratch holds count.x * count.y * count.z floats. */
+	void FillFractal(const Fractal& fractal, const glm::vec3& origin, const glm::vec3& step,
+		const glm::ivec3& count, float* out, float* scratch) const;
+
+	Timings GetTimings() const;
+	void ResetTimings();
+
+	const Settings& GetSettings() const { return m_settings; }
+
+	static const char* StageName(Stage stage);
+
+private:
+	void AddTime(Stage stage, uint64_t nanoseconds) const;
+
+	const PerlinNoise& m_noise;
+	Settings m_settings;
+	mutable std::array<std::atomic<uint64_t>, s_stageCount> m_nanoseconds{};
+	mutable std::atomic<uint64_t> m_columns{ 0 };
+};
@@ -0,0 +1,129 @@
+#include "WorldStorage.h"
+
+#include <algorithm>
+#include <string>
+#include <system_error>
+
+WorldStorage::WorldStorage(const std::filesystem::path& directory)
+	: m_directory(CreateDirectory(directory)),
+	m_journal(m_directory / "edits.journal") {
+	m_writer = std::thread(&WorldStorage::WriterLoop, this);
+}
+
+WorldStorage::~WorldStorage() {
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_isStopping = true;
+	}
+	m_queueCondition.notify_one();
+	m_writer.join();
+	m_journal.Sync();
+}
+
+uint64_t WorldStorage::LogEdit(const glm::ivec2& chunkPos, uint32_t block, uint8_t type) {
+	return m_journal.Append(chunkPos, block, type);
+}
+
+bool WorldStorage::NeedsSnapshot(const glm::ivec2& chunkPos) {
+	if (m_journal.EditCount(chunkPos) < s_snapshotEdits) {
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	return m_queued.count(KeyOf(chunkPos)) == 0 && m_writing.count(KeyOf(chunkPos)) == 0;
+}
+
+void WorldStorage::SaveSnapshot(const glm::ivec2& chunkPos, std::vector<uint8_t> data, uint64_t sequence) {
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_queued[KeyOf(chunkPos)] = Snapshot{ std::move(data), sequence };
+	}
+	m_queueCondition.notify_one();
+}
+
+void WorldStorage::Flush() {
+	{
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		m_idleCondition.wait(lock, [this]() { return m_queued.empty() && m_writing.empty(); });
+	}
+	m_journal.Sync();
+}
+
+WorldStorage::Stats WorldStorage::GetStats() const {
+	Stats stats;
+	stats.m_loadedChunks = m_loadedChunks.load(std::memory_order_relaxed);
+	stats.m_savedChunks = m_savedChunks.load(std::memory_order_relaxed);
+	stats.m_savedBytes = m_savedBytes.load(std::memory_order_relaxed);
+	stats.m_failedWrites = m_failedWrites.load(std::memory_order_relaxed);
+	stats.m_journalEdits = m_journal.LiveRecords();
+	stats.m_journalRecords = m_journal.FileRecords();
+	return stats;
+}
+
+std::filesystem::path WorldStorage::CreateDirectory(const std::filesystem::path& directory) {
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	return directory;
+}
+
+RegionFile* WorldStorage::OpenRegion(const glm::ivec2& regionPos, bool create) {
+	std::unique_ptr<RegionFile>& region = m_regions[KeyOf(regionPos)];
+	if (!region) {
+		const std::filesystem::path path = m_directory
+			/ ("r." + std::to_string(regionPos.x) + "." + std::to_string(regionPos.y) + ".region");
+
+		std::error_code error;
+		if (create || std::filesystem::exists(path, error)) {
+			auto file = std::make_unique<RegionFile>(path);
+			if (file->IsValid()) {
+				region = std::move(file);
+			}
+		}
+	}
+	return region.get();
+}
+
+void WorldStorage::WriterLoop() {
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	while (true) {
+		m_queueCondition.wait(lock, [this]() { return m_isStopping || !m_queued.empty(); });
+		if (m_queued.empty()) {
+			break;
+		}
+
+		// Zapisujemy cala partie naraz; do konca zapisu Load czyta te chunki z m_writing
+		m_writing.swap(m_queued);
+		lock.unlock();
+		{
+			std::unique_lock<std::shared_mutex> regionsLock(m_regionsMutex);
+			std::vector<RegionFile*> written;
+			for (const auto& [key, snapshot] : m_writing) {
+				const glm::ivec2 chunkPos(key.first, key.second);
+				const std::vector<uint8_t>& data = snapshot.m_data;
+				RegionFile* region = OpenRegion(RegionFile::RegionOf(chunkPos), true);
+				if (!region || !region->Write(RegionFile::IndexOf(chunkPos), data.data(), data.size())) {
+					m_failedWrites.fetch_add(1, std::memory_order_relaxed);
+					continue;
+				}
+
+				// Migawka jest na dysku, wiec zawarte w niej edycje nie musza byc juz odtwarzane
+				m_journal.Drop(chunkPos, snapshot.m_sequence);
+				m_savedChunks.fetch_add(1, std::memory_order_relaxed);
+				m_savedBytes.fetch_add(data.size(), std::memory_order_relaxed);
+				if (std::find(written.begin(), written.end(), region) == written.end()) {
+					written.push_back(region);
+				}
+			}
+
+			// Mapowanie odswiezamy raz na region, a nie po kazdym chunku
+			for (RegionFile* region : written) {
+				region->Remap();
+			}
+		}
+		lock.lock();
+
+		m_writing.clear();
+		if (m_queued.empty()) {
+			m_idleCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include "EditJournal.h"
+#include "RegionFile.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/** Saved state of one world, kept in a directory.
+ * Block edits are appended to an EditJournal and replayed over the generated (or snapshot)
+ * blocks when a chunk is loaded. Once a chunk collects s_snapshotEdits edits, its whole state
+ * is saved as a snapshot into region files and the edits it contains are dropped from the
+ * journal. Chunks which were never edited are not stored at all, they are generated again.
+ * SaveSnapshot only queues the data, a background thread writes it to the region files, so
+ * saving never waits for the disk. Load can be called from any thread, including job queue
+ * workers; a snapshot which is still waiting to be written is read from the queue.
+ */
+class WorldStorage {
+public:
+	struct Stats {
+		uint64_t m_loadedChunks{ 0 };
+		uint64_t m_savedChunks{ 0 };
+		uint64_t m_savedBytes{ 0 };
+		uint64_t m_failedWrites{ 0 };
+		uint64_t m_journalEdits{ 0 };		// edycje jeszcze nie objete migawka
+		uint64_t m_journalRecords{ 0 };		// rekordy w pliku dziennika
+	};
+
+	static constexpr size_t s_snapshotEdits = 64;
+
+	explicit WorldStorage(const std::filesystem::path& directory);
+
+	/** Writes everything still queued and syncs the journal. */
+	~WorldStorage();
+
+	WorldStorage(const WorldStorage&) = delete;
+	WorldStorage& operator=(const WorldStorage&) = delete;
+
+	/** Calls read(const uint8_t* data, size_t size) with the chunk snapshot. Returns false if there
+	 * is no snapshot, otherwise the result of read. Region data is passed straight from the mapping.
+	 * Journaled edits are not included, they have to be applied with ReplayEdits.
+	 */
+	template <typename Reader>
+	bool Load(const glm::ivec2& chunkPos, Reader&& read);
+
+	/** Records an edit of one block; block is the index of the block inside the chunk. Returns
+	 * the sequence number of the edit.
+	 */
+	uint64_t LogEdit(const glm::ivec2& chunkPos, uint32_t block, uint8_t type);
+
+	/** Calls apply(uint32_t block, uint8_t type) for every journaled edit of the chunk, oldest first. */
+	template <typename Apply>
+	void ReplayEdits(const glm::ivec2& chunkPos, Apply&& apply) const { m_journal.Replay(chunkPos, apply); }
+
+	/** Tells whether the chunk has enough journaled edits to be saved as a snapshot, and no snapshot is queued yet. */
+	bool NeedsSnapshot(const glm::ivec2& chunkPos);
+
+	/** Queues a snapshot of the chunk containing all its edits up to the given sequence number,
+	 * replacing the snapshot queued earlier. Those edits are dropped from the journal once the
+	 * snapshot is on the disk.
+	 */
+	void SaveSnapshot(const glm::ivec2& chunkPos, std::vector<uint8_t> data, uint64_t sequence);
+
+	/** Waits until all queued snapshots and journaled edits are written. */
+	void Flush();
+
+	Stats GetStats() const;
+
+private:
+	using Key = std::pair<int, int>;
+
+	struct Snapshot {
+		std::vector<uint8_t> m_data;
+		uint64_t m_sequence;
+	};
+
+	static Key KeyOf(const glm::ivec2& position) { return Key(position.x, position.y); }
+
+	/** Returns the open region or nullptr if its file does not exist; m_regionsMutex must be held exclusively. */
+	RegionFile* OpenRegion(const glm::ivec2& regionPos, bool create);
+
+	void WriterLoop();
+
+	static std::filesystem::path CreateDirectory(const std::filesystem::path& directory);
+
+	std::filesystem::path m_directory;
+	EditJournal m_journal;
+
+	// Odczyty wspoldzielone, watek zapisujacy na wylacznosc
+	std::shared_mutex m_regionsMutex;
+	std::map<Key, std::unique_ptr<RegionFile>> m_regions;   // nullptr - pliku nie ma
+
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueCondition;
+	std::condition_variable m_idleCondition;
+	std::map<Key, Snapshot> m_queued;
+	std::map<Key, Snapshot> m_writing;   // zdjete z kolejki, jeszcze nie w pliku
+	bool m_isStopping{ false };
+
+	std::atomic<uint64_t> m_loadedChunks{ 0 };
+	std::atomic<uint64_t> m_savedChunks{ 0 };
+	std::atomic<uint64_t> m_savedBytes{ 0 };
+	std::atomic<uint64_t> m_failedWrites{ 0 };
+
+	std::thread m_writer;
+};
+
+template <typename Reader>
+inline bool WorldStorage::Load(const glm::ivec2& chunkPos, Reader&& read) {
+	const Key key = KeyOf(chunkPos);
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		for (const auto* pending : { &m_queued, &m_writing }) {
+			auto it = pending->find(key);
+			if (it != pending->end()) {
+				const bool isRead = read(it->second.m_data.data(), it->second.m_data.size());
+				if (isRead) {
+					m_loadedChunks.fetch_add(1, std::memory_order_relaxed);
+				}
+				return isRead;
+			}
+		}
+	}
+
+	const glm::ivec2 regionPos = RegionFile::RegionOf(chunkPos);
+	std::shared_lock<std::shared_mutex> lock(m_regionsMutex);
+	auto it = m_regions.find(KeyOf(regionPos));
+	if (it == m_regions.end()) {
+		// Pierwszy odczyt z tego regionu - otwieramy plik na wylacznosc i wracamy do odczytu wspoldzielonego
+		lock.unlock();
+		{
+			std::unique_lock<std::shared_mutex> exclusive(m_regionsMutex);
+			OpenRegion(regionPos, false);
+		}
+		lock.lock();
+		it = m_regions.find(KeyOf(regionPos));
+	}
+
+	const RegionFile* region = it->second.get();
+	if (!region || !region->Read(RegionFile::IndexOf(chunkPos), read)) {
+		return false;
+	}
+	m_loadedChunks.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}